@@ -25,16 +25,21 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <climits>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <initializer_list>
 #include <istream>
 #include <iterator>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <ostream>
+#include <system_error>
+#include <thread>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -214,11 +219,49 @@
 #   define _YAEF_INTRINSICS_HAVE_AVX2 1
 #endif
 
+#if !defined(_YAEF_INTRINSICS_HAVE_AVX512) && defined(__AVX512F__) && defined(__AVX512BW__) && \
+    defined(__AVX512DQ__) && defined(__AVX512VL__) && defined(__AVX512VPOPCNTDQ__) && \
+    defined(__AVX512VBMI__)
+#   define _YAEF_INTRINSICS_HAVE_AVX512 1
+#endif
+
+// kernels marked with a target attribute can be emitted without enabling the isa for the
+// whole translation unit, and are only reached after cpuid says they are safe to run.
+#if !defined(YAEF_OPTS_NO_RUNTIME_DISPATCH) && (defined(__x86_64__) || defined(_M_X64))
+#   if defined(__GNUC__) || defined(__clang__)
+#       include <cpuid.h>
+#       define _YAEF_ATTR_TARGET(_isa) __attribute__((target(_isa)))
+#       define _YAEF_USE_RUNTIME_DISPATCH 1
+#   elif defined(_MSC_VER)
+#       define _YAEF_ATTR_TARGET(_isa)
+#       define _YAEF_USE_RUNTIME_DISPATCH 1
+#   endif
+#endif
+
+#ifndef _YAEF_ATTR_TARGET
+#   define _YAEF_ATTR_TARGET(_isa)
+#endif
+
+#define _YAEF_ATTR_TARGET_AVX2 _YAEF_ATTR_TARGET("avx2,popcnt")
+#define _YAEF_ATTR_TARGET_AVX512 _YAEF_ATTR_TARGET("avx512f,avx512bw,avx512dq,avx512vl,avx512vpopcntdq,avx512vbmi,popcnt")
+
+#if _YAEF_INTRINSICS_HAVE_AVX2 || _YAEF_USE_RUNTIME_DISPATCH
+#   define _YAEF_INTRINSICS_CAN_EMIT_AVX2 1
+#endif
+
+#if _YAEF_INTRINSICS_HAVE_AVX512 || _YAEF_USE_RUNTIME_DISPATCH
+#   define _YAEF_INTRINSICS_CAN_EMIT_AVX512 1
+#endif
+
 #ifndef YAEF_OPTS_NO_EXCEPTION
 #   define _YAEF_THROW(...) throw (__VA_ARGS__)
+#   define _YAEF_TRY try
+#   define _YAEF_CATCH(...) catch (__VA_ARGS__)
 #   define _YAEF_MAYBE_NOEXCEPT 
 #else
 #   define _YAEF_THROW(...) ::abort()
+#   define _YAEF_TRY if (true)
+#   define _YAEF_CATCH(...) else if (false)
 #   define _YAEF_MAYBE_NOEXCEPT noexcept
 #endif
 
@@ -233,7 +276,7 @@
     _YAEF_CONCAT(_YAEF_CONCAT(_YAEF_CONCAT(_a, _sep), _YAEF_CONCAT(_b, _sep)), _c)
 
 #define YAEF_VERSION_MAJOR 0
-#define YAEF_VERSION_MINOR 1
+#define YAEF_VERSION_MINOR 2
 #define YAEF_VERSION_PATCH 0
 
 #define YAEF_VERSION_NUM (((YAEF_VERSION_MAJOR) << 22) | ((YAEF_VERSION_MINOR) << 12) | (YAEF_VERSION_PATCH))
@@ -254,7 +297,9 @@ enum class error_code : uint32_t {
     not_sorted,
     serialize_io,
     deserialize_invalid_format,
-    deserialize_io
+    deserialize_io,
+    // the data was serialized with another sampling policy
+    deserialize_mismatched_policy
 };
 
 #if __cplusplus >= 202002L
@@ -268,6 +313,19 @@ enum class error_code : uint32_t {
         } while (false);
 #endif
 
+enum class serialize_flags : uint32_t {
+    none = 0,
+    // the select samples are left out, a loaded list rebuilds them on its first select
+    omit_select_samples = 1
+};
+
+enum class deserialize_flags : uint32_t {
+    none = 0,
+    // the select samples left out by `serialize_flags::omit_select_samples` are built by the 
+    // first select instead of on load, see `eliasfano_list::at`
+    lazy_select_samples = 1
+};
+
 template<uint32_t W>
 struct assumed_width_t : std::integral_constant<uint32_t, W> { };
 
@@ -276,6 +334,127 @@ template<uint32_t W>
 inline constexpr assumed_width_t<W> assumed_width;
 #endif
 
+// instruction set tiers of the block kernels, ordered from the least to the most capable
+enum class simd_tier : uint32_t {
+    scalar = 0,
+    avx2,
+    avx512
+};
+
+// boolean operations on bits, `bit_and_not` clears the bits of the left operand that are 
+// set in the right one
+enum class bitwise_op : uint32_t {
+    bit_and = 0,
+    bit_or,
+    bit_xor,
+    bit_and_not
+};
+
+// which bits of a bitvector get select samples. a list that is only accessed by index 
+// selects its 1s only, `lower_bound` and the other searches select its 0s.
+enum class select_sides : uint32_t {
+    ones  = 1,
+    zeros = 2,
+    both  = ones | zeros
+};
+
+_YAEF_ATTR_NODISCARD constexpr bool has_select_side(select_sides sides, select_sides side) noexcept {
+    return (static_cast<uint32_t>(sides) & static_cast<uint32_t>(side)) == static_cast<uint32_t>(side);
+}
+
+// the sampling scheme of the select indexes, as in the darray of Okanohara and Sadakane: the 
+// position of every `SampleRate`-th 1 (or 0) is sampled. if the block between two samples spans 
+// at least `EachOneMinLen` bits, the positions of all of its bits are stored, otherwise every 
+// `SubsampleRate`-th one, both relative to the sample. a select scans the bits from the closest 
+// (sub)sample, so denser samples trade space for latency.
+template<size_t SampleRate, size_t SubsampleRate, size_t EachOneMinLen, 
+         select_sides Sides = select_sides::both>
+struct darray_sampling_policy {
+    static_assert(SubsampleRate != 0 && SampleRate % SubsampleRate == 0, 
+                  "the sample rate must be a multiple of the subsample rate");
+
+    static constexpr size_t       SAMPLE_RATE      = SampleRate;
+    static constexpr size_t       SUBSAMPLE_RATE   = SubsampleRate;
+    static constexpr size_t       EACH_ONE_MIN_LEN = EachOneMinLen;
+    static constexpr select_sides SIDES            = Sides;
+};
+
+// the sampling of `eliasfano_list` unless another one is given
+using default_sampling_policy = darray_sampling_policy<4096, 64, 65536>;
+// the parameters suggested by the darray paper
+using okanohara_sadakane_sampling_policy = darray_sampling_policy<1024, 32, 65536>;
+// about twice the space of the default, for latency critical lists
+using low_latency_sampling_policy = darray_sampling_policy<1024, 16, 16384>;
+// the samples only, no subsamples are stored and selects scan up to a whole block
+using compact_sampling_policy = darray_sampling_policy<4096, 4096, SIZE_MAX>;
+// the default sampling of the 1s only, for lists that are accessed by index but never searched
+using access_only_sampling_policy = darray_sampling_policy<4096, 64, 65536, select_sides::ones>;
+
+// executors run `task(i)` for every i in [0, num_tasks) and return after all of them have 
+// finished. the parallel algorithms accept any callable of this form, e.g. one that forwards 
+// the tasks to an existing thread pool. an exception thrown by a task reaches the caller of 
+// the parallel algorithm, the tasks that have not started by then may be skipped.
+struct sequential_executor {
+    template<typename F>
+    void operator()(size_t num_tasks, const F &task) const {
+        for (size_t i = 0; i < num_tasks; ++i) {
+            task(i);
+        }
+    }
+};
+
+// spawn the threads for every call, the calling thread is one of the workers. the first 
+// exception of a task stops handing out tasks and is rethrown after all threads are joined. 
+// if a thread cannot be spawned, the tasks run on the threads started so far.
+class thread_executor {
+public:
+    explicit thread_executor(size_t num_threads = std::thread::hardware_concurrency()) noexcept
+        : num_threads_(std::max<size_t>(num_threads, 1)) { }
+
+    _YAEF_ATTR_NODISCARD size_t concurrency() const noexcept { return num_threads_; }
+
+    template<typename F>
+    void operator()(size_t num_tasks, const F &task) const {
+        std::atomic<size_t> next_task{0};
+        std::atomic<bool> failed{false};
+        std::exception_ptr first_error;
+        auto worker = [&]() {
+            _YAEF_TRY {
+                for (size_t i = next_task.fetch_add(1, std::memory_order_relaxed); i < num_tasks; 
+                     i = next_task.fetch_add(1, std::memory_order_relaxed)) {
+                    task(i);
+                }
+            } _YAEF_CATCH(...) {
+                if (!failed.exchange(true)) {
+                    first_error = std::current_exception();
+                }
+                next_task.store(num_tasks, std::memory_order_relaxed);
+            }
+        };
+        const size_t num_workers = std::min(num_threads_, num_tasks);
+        std::vector<std::thread> threads;
+        threads.reserve(num_workers);
+        for (size_t i = 1; i < num_workers; ++i) {
+            _YAEF_TRY {
+                threads.emplace_back(worker);
+            } _YAEF_CATCH(const std::system_error &) {
+                break;
+            }
+        }
+        // `worker` does not throw, so every started thread is joined
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        if (first_error) {
+            std::rethrow_exception(first_error);
+        }
+    }
+
+private:
+    size_t num_threads_;
+};
+
 namespace details {
 
 inline void raise_assertion(const char *filename, int line, const char *expr) {
@@ -657,11 +836,15 @@ private:
 
 class serializer {
 public:
-    serializer(std::unique_ptr<writer_context> &&ctx) noexcept
-        : ctx_(std::move(ctx)) { }
+    serializer(std::unique_ptr<writer_context> &&ctx, serialize_flags flags = serialize_flags::none) noexcept
+        : ctx_(std::move(ctx)), flags_(flags) { }
     
     _YAEF_ATTR_NODISCARD const writer_context &context() const { return *ctx_; }
     _YAEF_ATTR_NODISCARD writer_context &context() { return *ctx_; }
+
+    _YAEF_ATTR_NODISCARD bool has_flags(serialize_flags flags) const noexcept {
+        return (static_cast<uint32_t>(flags_) & static_cast<uint32_t>(flags)) == static_cast<uint32_t>(flags);
+    }
     
     template<typename T>
     bool write(const T &val) {
@@ -678,15 +861,20 @@ public:
 
 private:
     std::unique_ptr<writer_context> ctx_;
+    serialize_flags                 flags_;
 };
 
 class deserializer {
 public:
-    deserializer(std::unique_ptr<reader_context> &&ctx) noexcept
-        : ctx_(std::move(ctx)) { }
+    deserializer(std::unique_ptr<reader_context> &&ctx, deserialize_flags flags = deserialize_flags::none) noexcept
+        : ctx_(std::move(ctx)), flags_(flags) { }
     
     _YAEF_ATTR_NODISCARD const reader_context &context() const { return *ctx_; }
     _YAEF_ATTR_NODISCARD reader_context &context() { return *ctx_; }
+
+    _YAEF_ATTR_NODISCARD bool has_flags(deserialize_flags flags) const noexcept {
+        return (static_cast<uint32_t>(flags_) & static_cast<uint32_t>(flags)) == static_cast<uint32_t>(flags);
+    }
     
     template<typename T>
     bool read(T &val) {
@@ -703,6 +891,7 @@ public:
 
 private:
     std::unique_ptr<reader_context> ctx_;
+    deserialize_flags               flags_;
 };
 
 struct serialize_friend_access {
@@ -730,6 +919,115 @@ _YAEF_ATTR_NODISCARD inline T exchange(T &obj, U &&new_val)
 #endif
 }
 
+struct cpu_features {
+    bool popcnt          = false;
+    bool bmi2            = false;
+    bool fast_pdep       = false;
+    bool avx2            = false;
+    bool avx512f         = false;
+    bool avx512bw        = false;
+    bool avx512dq        = false;
+    bool avx512vl        = false;
+    bool avx512vbmi      = false;
+    bool avx512vbmi2     = false;
+    bool avx512vpopcntdq = false;
+    bool avx512bitalg    = false;
+};
+
+#if _YAEF_USE_RUNTIME_DISPATCH
+inline void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) {
+        regs[i] = static_cast<uint32_t>(out[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0 tells which register states the os saves on context switches
+inline uint64_t read_xcr0() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return _xgetbv(0);
+#else
+    uint32_t eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
+#endif
+
+_YAEF_ATTR_NODISCARD inline cpu_features detect_cpu_features() noexcept {
+    cpu_features features;
+#if _YAEF_USE_RUNTIME_DISPATCH
+    constexpr uint64_t XCR0_AVX_STATE    = 0x06; // xmm, ymm
+    constexpr uint64_t XCR0_AVX512_STATE = 0xE6; // xmm, ymm, opmask, zmm
+
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    const uint32_t max_leaf = regs[0];
+    if (max_leaf < 7) {
+        return features;
+    }
+    char vendor[12];
+    memcpy(vendor + 0, &regs[1], sizeof(uint32_t));
+    memcpy(vendor + 4, &regs[3], sizeof(uint32_t));
+    memcpy(vendor + 8, &regs[2], sizeof(uint32_t));
+    const bool is_amd = memcmp(vendor, "AuthenticAMD", 12) == 0 || 
+                        memcmp(vendor, "HygonGenuine", 12) == 0;
+
+    cpuid(1, 0, regs);
+    const uint32_t base_family = (regs[0] >> 8) & 0xF;
+    const uint32_t family = base_family == 0xF ? base_family + ((regs[0] >> 20) & 0xFF) : base_family;
+    const bool has_osxsave = (regs[2] >> 27) & 1;
+    const bool has_avx = (regs[2] >> 28) & 1;
+    features.popcnt = (regs[2] >> 23) & 1;
+
+    const uint64_t xcr0 = has_osxsave ? read_xcr0() : 0;
+    const bool os_avx = has_avx && (xcr0 & XCR0_AVX_STATE) == XCR0_AVX_STATE;
+    const bool os_avx512 = os_avx && (xcr0 & XCR0_AVX512_STATE) == XCR0_AVX512_STATE;
+
+    cpuid(7, 0, regs);
+    features.bmi2 = (regs[1] >> 8) & 1;
+    // PDEP/PEXT are microcoded on AMD before Zen3 (family 0x19), taking hundreds of cycles
+    features.fast_pdep = features.bmi2 && !(is_amd && family < 0x19);
+    features.avx2 = os_avx && ((regs[1] >> 5) & 1);
+    if (os_avx512) {
+        features.avx512f         = (regs[1] >> 16) & 1;
+        features.avx512dq        = (regs[1] >> 17) & 1;
+        features.avx512bw        = (regs[1] >> 30) & 1;
+        features.avx512vl        = (regs[1] >> 31) & 1;
+        features.avx512vbmi      = (regs[2] >> 1) & 1;
+        features.avx512vbmi2     = (regs[2] >> 6) & 1;
+        features.avx512bitalg    = (regs[2] >> 12) & 1;
+        features.avx512vpopcntdq = (regs[2] >> 14) & 1;
+    }
+#else
+    // without cpuid, trust whatever the translation unit is compiled for
+#   if defined(__POPCNT__) || _YAEF_INTRINSICS_HAVE_AVX2
+    features.popcnt = true;
+#   endif
+#   if _YAEF_INTRINSICS_HAVE_BMI2
+    features.bmi2 = features.fast_pdep = true;
+#   endif
+#   if _YAEF_INTRINSICS_HAVE_AVX2
+    features.avx2 = true;
+#   endif
+#   if _YAEF_INTRINSICS_HAVE_AVX512
+    features.avx512f = features.avx512bw = features.avx512dq = 
+        features.avx512vl = features.avx512vpopcntdq = true;
+#   endif
+#endif
+    return features;
+}
+
+_YAEF_ATTR_NODISCARD inline const cpu_features &get_cpu_features() noexcept {
+    static const cpu_features features = detect_cpu_features();
+    return features;
+}
+
 namespace bits64 {
 
 template<uint64_t M>
@@ -780,6 +1078,8 @@ _YAEF_ATTR_NODISCARD inline uint32_t count_leading_zero(uint64_t block) noexcept
 #if _YAEF_USE_STL_BITOPS_IMPL
     return std::countl_zero(block);
 #elif _YAEF_HAS_BUILTIN(__builtin_clzll)
+    // __builtin_clzll(0) is undefined, `bit_width(0)` relies on getting 64 here
+    if (_YAEF_UNLIKELY(block == 0)) { return 64; }
     return __builtin_clzll(block);
 #elif defined(_MSC_VER)
 #   ifdef __AVX2__
@@ -1062,13 +1362,25 @@ _YAEF_ATTR_NODISCARD inline uint32_t select_one_fallback(uint64_t block, uint32_
     return place + SELECT_IN_BYTE_LUT[((block >> place) & 0xFF) | (byte_rank << 8)];
 }
 
+// decides whether `select_one` goes through PDEP. it is read before the cpu is detected
+// only during static initialization, where the zero-initialized value picks the fallback.
+// it is atomic so that it can be forced while other threads run queries.
+template<typename Dummy = void>
+struct pdep_select_switch {
+    static std::atomic<bool> enabled;
+};
+
+template<typename Dummy>
+std::atomic<bool> pdep_select_switch<Dummy>::enabled{get_cpu_features().fast_pdep};
+
 _YAEF_ATTR_NODISCARD inline uint32_t select_one(uint64_t block, uint32_t k) noexcept {
     _YAEF_ASSERT(k < 64);
 #if _YAEF_INTRINSICS_HAVE_BMI2
-    return count_trailing_zero(_pdep_u64(static_cast<uint64_t>(1) << k, block));
-#else
-    return select_one_fallback(block, k);
+    if (_YAEF_LIKELY(pdep_select_switch<>::enabled.load(std::memory_order_relaxed))) {
+        return count_trailing_zero(_pdep_u64(static_cast<uint64_t>(1) << k, block));
+    }
 #endif
+    return select_one_fallback(block, k);
 }
 
 _YAEF_ATTR_NODISCARD inline uint32_t select_zero(uint64_t block, uint32_t k) noexcept {
@@ -1088,8 +1400,8 @@ _YAEF_ATTR_NODISCARD inline uint64_t idiv_ceil_nzero(uint64_t lhs, uint64_t rhs)
 }
 
 // return count of 1s in preceding k bits 
-_YAEF_ATTR_NODISCARD inline size_t 
-popcount_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+_YAEF_ATTR_NODISCARD inline size_t
+popcount_blocks_scalar(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
 
     k = std::min(k, num_blocks * BLOCK_WIDTH);
@@ -1106,9 +1418,11 @@ popcount_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
     return num_ones;
 }
 
-#if _YAEF_INTRINSICS_HAVE_AVX512
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX512
+// the zero-masked shuffles below avoid the undefined source operand of the unmasked
+// ones, which some gcc versions report as -Wuninitialized.
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 popcount_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1123,9 +1437,9 @@ popcount_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k)
     }
 
     __m512i popcnts_vec =  _mm512_popcnt_epi64(loaded_vec);
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 1));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 2));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 4));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 1));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 2));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 4));
 
     const size_t last_block_index = k / BLOCK_WIDTH, 
                  last_rem_bits = k % BLOCK_WIDTH;
@@ -1144,7 +1458,7 @@ popcount_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k)
 }
 
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 popcount_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1163,14 +1477,14 @@ popcount_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t k)
     popcnts_vecs[0] = _mm512_popcnt_epi64(loaded_vecs[0]);
     popcnts_vecs[1] = _mm512_popcnt_epi64(loaded_vecs[1]);
 
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 1));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 2));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 4));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 1));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 2));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 4));
 
-    __m512i prv_sum = _mm512_permutexvar_epi64(_mm512_set1_epi64(7), popcnts_vecs[0]);
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 1));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 2));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 4));
+    __m512i prv_sum = _mm512_maskz_permutexvar_epi64(0xFF, _mm512_set1_epi64(7), popcnts_vecs[0]);
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 1));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 2));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 4));
     popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], prv_sum);
 
     const size_t last_block_index = k / BLOCK_WIDTH, 
@@ -1192,8 +1506,254 @@ popcount_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t k)
 }
 #endif
 
+// return count of 1s in the first n blocks
 _YAEF_ATTR_NODISCARD inline size_t
-select_one_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+popcount_range_scalar(const uint64_t *blocks, size_t n) {
+    size_t num_ones = 0;
+    for (size_t i = 0; i < n; ++i) {
+        num_ones += popcount(blocks[i]);
+    }
+    return num_ones;
+}
+
+// packed ints are (un)packed in groups of 8, a group always starts at a byte boundary and 
+// spans `width` bytes. the unpack kernels may read 64 bytes from the start of each group,
+// while the pack kernels write exactly `width` bytes per group.
+constexpr size_t   PACKED_GROUP_SIZE = 8;
+constexpr size_t   UNPACK_GROUP_READ_BYTES = 64;
+constexpr uint32_t PACKED_GROUP_MAX_WIDTH = 56;
+
+inline void unpack_ints_scalar(const uint8_t *src, uint32_t width, size_t num_groups, uint64_t *out) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    for (size_t g = 0; g < num_groups; ++g) {
+        for (uint32_t j = 0; j < PACKED_GROUP_SIZE; ++j) {
+            const uint32_t bit_offset = j * width;
+            uint64_t word;
+            memcpy(&word, src + bit_offset / 8, sizeof(word));
+            out[j] = (word >> (bit_offset % 8)) & mask;
+        }
+        src += width;
+        out += PACKED_GROUP_SIZE;
+    }
+}
+
+// bit j of `out[g]` is set if the j-th value of the g-th group is in [min, min + range]
+inline void scan_ints_scalar(const uint8_t *src, uint32_t width, size_t num_groups, 
+                             uint64_t min, uint64_t range, uint8_t *out) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    for (size_t g = 0; g < num_groups; ++g) {
+        uint8_t matches = 0;
+        for (uint32_t j = 0; j < PACKED_GROUP_SIZE; ++j) {
+            const uint32_t bit_offset = j * width;
+            uint64_t word;
+            memcpy(&word, src + bit_offset / 8, sizeof(word));
+            const uint64_t value = (word >> (bit_offset % 8)) & mask;
+            matches |= static_cast<uint8_t>((value - min <= range) << j);
+        }
+        out[g] = matches;
+        src += width;
+    }
+}
+
+// returns the index of the first value in [first, last) not less than `target`, or `last` 
+// if there is no such value. the indices count from the first group at `src`.
+_YAEF_ATTR_NODISCARD inline size_t 
+find_ints_not_less_scalar(const uint8_t *src, uint32_t width, size_t first, size_t last, uint64_t target) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    for (size_t i = first, bit_offset = first * width; i < last; ++i, bit_offset += width) {
+        uint64_t word;
+        memcpy(&word, src + bit_offset / 8, sizeof(word));
+        if (((word >> (bit_offset % 8)) & mask) >= target) {
+            return i;
+        }
+    }
+    return last;
+}
+
+// write the inclusive prefix sums of the values in the groups, starting from `init`, 
+// and return the last sum
+inline uint64_t unpack_prefix_sum_ints_scalar(const uint8_t *src, uint32_t width, size_t num_groups, 
+                                              uint64_t init, uint64_t *out) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    const size_t num_values = num_groups * PACKED_GROUP_SIZE;
+    for (size_t i = 0, bit_offset = 0; i < num_values; ++i, bit_offset += width) {
+        uint64_t word;
+        memcpy(&word, src + bit_offset / 8, sizeof(word));
+        init += (word >> (bit_offset % 8)) & mask;
+        out[i] = init;
+    }
+    return init;
+}
+
+// replace each value by its difference to the previous one, the value before `values[0]` 
+// is `prev`. the differences wrap around in unsigned arithmetic.
+inline void delta_values_scalar(uint64_t *values, size_t n, uint64_t prev) {
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t cur = values[i];
+        values[i] = cur - prev;
+        prev = cur;
+    }
+}
+
+_YAEF_ATTR_NODISCARD inline uint64_t max_ints_scalar(const uint8_t *src, uint32_t width, size_t num_groups) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    const size_t num_values = num_groups * PACKED_GROUP_SIZE;
+    uint64_t res = 0;
+    for (size_t i = 0, bit_offset = 0; i < num_values; ++i, bit_offset += width) {
+        uint64_t word;
+        memcpy(&word, src + bit_offset / 8, sizeof(word));
+        res = std::max(res, (word >> (bit_offset % 8)) & mask);
+    }
+    return res;
+}
+
+template<bitwise_op Op>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE uint64_t apply_bitwise_op(uint64_t lhs, uint64_t rhs) noexcept {
+    switch (Op) {
+    case bitwise_op::bit_and : return lhs & rhs;
+    case bitwise_op::bit_or  : return lhs | rhs;
+    case bitwise_op::bit_xor : return lhs ^ rhs;
+    default                  : return lhs & ~rhs;
+    }
+}
+
+// instantiate `KernelT::run<Op, Count>` for the operation and whether to count the 1s
+template<typename KernelT>
+_YAEF_ATTR_NODISCARD inline size_t 
+dispatch_bitwise_kernel(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n, 
+                        bitwise_op op, bool count) {
+    switch (op) {
+    case bitwise_op::bit_and :
+        return count ? KernelT::template run<bitwise_op::bit_and, true>(dst, lhs, rhs, n) :
+                       KernelT::template run<bitwise_op::bit_and, false>(dst, lhs, rhs, n);
+    case bitwise_op::bit_or :
+        return count ? KernelT::template run<bitwise_op::bit_or, true>(dst, lhs, rhs, n) :
+                       KernelT::template run<bitwise_op::bit_or, false>(dst, lhs, rhs, n);
+    case bitwise_op::bit_xor :
+        return count ? KernelT::template run<bitwise_op::bit_xor, true>(dst, lhs, rhs, n) :
+                       KernelT::template run<bitwise_op::bit_xor, false>(dst, lhs, rhs, n);
+    default :
+        return count ? KernelT::template run<bitwise_op::bit_and_not, true>(dst, lhs, rhs, n) :
+                       KernelT::template run<bitwise_op::bit_and_not, false>(dst, lhs, rhs, n);
+    }
+}
+
+struct bitwise_blocks_scalar_kernel {
+    template<bitwise_op Op, bool Count>
+    static size_t run(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n) {
+        size_t num_ones = 0;
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t block = apply_bitwise_op<Op>(lhs[i], rhs[i]);
+            dst[i] = block;
+            if (Count) { num_ones += popcount(block); }
+        }
+        return num_ones;
+    }
+};
+
+// write `lhs op rhs` of n blocks to `dst`, which may be `lhs` or `rhs`. returns the number 
+// of 1s in the result if `count`, otherwise 0.
+_YAEF_ATTR_NODISCARD inline size_t 
+bitwise_blocks_scalar(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n, 
+                      bitwise_op op, bool count) {
+    return dispatch_bitwise_kernel<bitwise_blocks_scalar_kernel>(dst, lhs, rhs, n, op, count);
+}
+
+// return the index of the first of n blocks that contains a `Bit`, or n if there is none
+template<bool Bit>
+_YAEF_ATTR_NODISCARD inline size_t find_block_with_bit_scalar_impl(const uint64_t *blocks, size_t n) {
+    constexpr uint64_t EMPTY_BLOCK = Bit ? 0 : UINT64_MAX;
+    for (size_t i = 0; i < n; ++i) {
+        if (blocks[i] != EMPTY_BLOCK) { return i; }
+    }
+    return n;
+}
+
+// return the index of the last of n blocks that contains a `Bit`, or n if there is none
+template<bool Bit>
+_YAEF_ATTR_NODISCARD inline size_t rfind_block_with_bit_scalar_impl(const uint64_t *blocks, size_t n) {
+    constexpr uint64_t EMPTY_BLOCK = Bit ? 0 : UINT64_MAX;
+    for (size_t i = n; i > 0; --i) {
+        if (blocks[i - 1] != EMPTY_BLOCK) { return i - 1; }
+    }
+    return n;
+}
+
+_YAEF_ATTR_NODISCARD inline size_t find_block_with_bit_scalar(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? find_block_with_bit_scalar_impl<true>(blocks, n) : find_block_with_bit_scalar_impl<false>(blocks, n);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t rfind_block_with_bit_scalar(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? rfind_block_with_bit_scalar_impl<true>(blocks, n) : rfind_block_with_bit_scalar_impl<false>(blocks, n);
+}
+
+// the 1s of `block` that follow a 0, `prev_block` provides the bit before the first one
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE uint64_t run_starts(uint64_t block, uint64_t prev_block) noexcept {
+    return block & ~((block << 1) | (prev_block >> 63));
+}
+
+// the 0s of `block` that follow a 1, i.e. the bits right after the runs of 1s
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE uint64_t run_ends(uint64_t block, uint64_t prev_block) noexcept {
+    return ~block & ((block << 1) | (prev_block >> 63));
+}
+
+template<bool Bit, typename T>
+_YAEF_ATTR_NODISCARD inline size_t decode_bits_scalar_impl(const uint64_t *blocks, size_t n, T *out, T index_offset) {
+    size_t num_decoded = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t block = Bit ? blocks[i] : ~blocks[i];
+        const T block_offset = index_offset + static_cast<T>(i * 64);
+        while (block != 0) {
+            out[num_decoded++] = block_offset + static_cast<T>(count_trailing_zero(block));
+            block &= block - 1;
+        }
+    }
+    return num_decoded;
+}
+
+// write the indices of the `bit`s in n blocks, plus `index_offset`, to `out` in ascending order. 
+// `out` has room for `out_capacity` indices, which must be at least their number. the vector 
+// kernels may write past the last index, but never past `out + out_capacity`. returns their number.
+template<typename T>
+_YAEF_ATTR_NODISCARD inline size_t 
+decode_bits_scalar(const uint64_t *blocks, size_t n, bool bit, T *out, size_t out_capacity, T index_offset) {
+    const size_t num_decoded = bit ? decode_bits_scalar_impl<true>(blocks, n, out, index_offset) : 
+                                     decode_bits_scalar_impl<false>(blocks, n, out, index_offset);
+    _YAEF_ASSERT(num_decoded <= out_capacity);
+    (void)out_capacity;
+    return num_decoded;
+}
+
+// values are collected in a word and only whole words are written, instead of a 
+// read-modify-write on one or two words per value.
+inline void pack_ints_scalar(const uint64_t *src, uint32_t width, size_t num_groups, uint8_t *dst) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const uint64_t mask = make_mask_lsb1(width);
+    const size_t num_values = num_groups * PACKED_GROUP_SIZE;
+    uint64_t buffer = 0;
+    uint32_t num_buffered = 0;
+    for (size_t i = 0; i < num_values; ++i) {
+        const uint64_t value = src[i] & mask;
+        buffer |= value << num_buffered;
+        num_buffered += width;
+        if (num_buffered >= 64) {
+            memcpy(dst, &buffer, sizeof(buffer));
+            dst += sizeof(buffer);
+            num_buffered -= 64;
+            buffer = num_buffered == 0 ? 0 : value >> (width - num_buffered);
+        }
+    }
+    // whole groups always end at a byte boundary
+    memcpy(dst, &buffer, num_buffered / 8);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_one_blocks_scalar(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
 
     size_t num_ones = k + 1;
@@ -1203,7 +1763,19 @@ select_one_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
         return static_cast<size_t>(-1);
     }
 
-    for (size_t i = 0; i < num_blocks; ++i) {
+    // whole cache lines are skipped first, the popcounts of a line are independent
+    size_t i = 0;
+    for (; i + 8 <= num_blocks; i += 8) {
+        size_t line_num_ones = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            line_num_ones += popcount(blocks[i + j]);
+        }
+        if (num_ones <= line_num_ones) {
+            break;
+        }
+        num_ones -= line_num_ones;
+    }
+    for (; i < num_blocks; ++i) {
         uint32_t block_num_ones = popcount(blocks[i]);
         if (num_ones > block_num_ones) {
             num_ones -= block_num_ones;
@@ -1221,7 +1793,7 @@ select_one_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
 }
 
 _YAEF_ATTR_NODISCARD inline size_t
-select_zero_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+select_zero_blocks_scalar(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
 
     size_t num_zeros = k + 1;
@@ -1231,7 +1803,18 @@ select_zero_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
         return static_cast<size_t>(-1);
     }
 
-    for (size_t i = 0; i < num_blocks; ++i) {
+    size_t i = 0;
+    for (; i + 8 <= num_blocks; i += 8) {
+        size_t line_num_zeros = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            line_num_zeros += popcount(~blocks[i + j]);
+        }
+        if (num_zeros <= line_num_zeros) {
+            break;
+        }
+        num_zeros -= line_num_zeros;
+    }
+    for (; i < num_blocks; ++i) {
         uint32_t block_num_zeros = popcount(~blocks[i]);
         if (num_zeros > block_num_zeros) {
             num_zeros -= block_num_zeros;
@@ -1248,9 +1831,9 @@ select_zero_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
     return num_skipped_blocks * BLOCK_WIDTH + select_zero(*last_block, num_zeros - 1);
 }
 
-#if _YAEF_INTRINSICS_HAVE_AVX512
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX512
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 select_one_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1267,9 +1850,9 @@ select_one_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k
     }
  
     __m512i popcnts_vec =  _mm512_popcnt_epi64(loaded_vec); 
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 1));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 2));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 4));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 1));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 2));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 4));
     
     const __m512i index_vec = _mm512_set1_epi64(k + 1);
     const __mmask8 cmp_mask = _mm512_cmp_epu64_mask(index_vec, popcnts_vec, _MM_CMPINT_LE);
@@ -1288,7 +1871,7 @@ select_one_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k
 }
 
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 select_zero_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1306,9 +1889,9 @@ select_zero_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t
     loaded_vec = ~loaded_vec;
  
     __m512i popcnts_vec =  _mm512_popcnt_epi64(loaded_vec); 
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 1));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 2));
-    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_alignr_epi64(popcnts_vec, ZERO, 8 - 4));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 1));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 2));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 4));
     
     const __m512i index_vec = _mm512_set1_epi64(k + 1);
     const __mmask8 cmp_mask = _mm512_cmp_epu64_mask(index_vec, popcnts_vec, _MM_CMPINT_LE);
@@ -1327,7 +1910,7 @@ select_zero_blocks_512_avx512(const uint64_t *blocks, size_t num_blocks, size_t
 }
 
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 select_one_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1349,14 +1932,14 @@ select_one_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t
     popcnts_vecs[0] = _mm512_popcnt_epi64(loaded_vecs[0]);
     popcnts_vecs[1] = _mm512_popcnt_epi64(loaded_vecs[1]);
 
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 1));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 2));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 4));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 1));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 2));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 4));
 
-    __m512i prv_sum = _mm512_permutexvar_epi64(_mm512_set1_epi64(7), popcnts_vecs[0]);
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 1));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 2));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 4));
+    __m512i prv_sum = _mm512_maskz_permutexvar_epi64(0xFF, _mm512_set1_epi64(7), popcnts_vecs[0]);
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 1));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 2));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 4));
     popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], prv_sum);
 
     const __m512i index_vec = _mm512_set1_epi64(k + 1);
@@ -1381,7 +1964,7 @@ select_one_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t
 }
 
 template<bool Aligned = false>
-_YAEF_ATTR_NODISCARD inline size_t
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
 select_zero_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
     constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
     const __m512i ZERO = _mm512_setzero_si512();
@@ -1405,14 +1988,14 @@ select_zero_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t
     popcnts_vecs[0] = _mm512_popcnt_epi64(loaded_vecs[0]);
     popcnts_vecs[1] = _mm512_popcnt_epi64(loaded_vecs[1]);
 
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 1));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 2));
-    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_alignr_epi64(popcnts_vecs[0], ZERO, 8 - 4));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 1));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 2));
+    popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[0], ZERO, 8 - 4));
 
-    __m512i prv_sum = _mm512_permutexvar_epi64(_mm512_set1_epi64(7), popcnts_vecs[0]);
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 1));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 2));
-    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_alignr_epi64(popcnts_vecs[1], ZERO, 8 - 4));
+    __m512i prv_sum = _mm512_maskz_permutexvar_epi64(0xFF, _mm512_set1_epi64(7), popcnts_vecs[0]);
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 1));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 2));
+    popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_maskz_alignr_epi64(0xFF, popcnts_vecs[1], ZERO, 8 - 4));
     popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], prv_sum);
 
     const __m512i index_vec = _mm512_set1_epi64(k + 1);
@@ -1435,93 +2018,1403 @@ select_zero_blocks_1024_avx512(const uint64_t *blocks, size_t num_blocks, size_t
     size_t pos_in_block = select_one(block, local_idx);
     return lane_idx * BLOCK_WIDTH + pos_in_block;
 }
-#endif
 
-class bit_view;
-class packed_int_view;
+// consumes a cache line (8 words) per step. whole lines are skipped with a single reduction, 
+// the prefix sums are only computed for the line holding the target, or the masked last line.
+template<bool BitType>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
+select_blocks_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+    const __m512i ZERO = _mm512_setzero_si512();
+    const __m512i FLIP_MASK = BitType ? ZERO : _mm512_set1_epi64(-1);
 
-class packed_int_view {
-public:
-    using value_type = uint64_t;
-    using block_type = uint64_t;
-    using size_type  = size_t;
-    static constexpr uint32_t BLOCK_WIDTH = sizeof(block_type) * CHAR_BIT;
+    if (_YAEF_UNLIKELY(k + 1 == 0)) {
+        return static_cast<size_t>(-1);
+    }
 
-public:
-    packed_int_view() noexcept
-        : blocks_(nullptr), num_elems_(0), width_(0) { }
+    size_t i = 0;
+    for (; i + 8 <= num_blocks; i += 8) {
+        const __m512i loaded_vec = _mm512_xor_si512(_mm512_loadu_si512(blocks + i), FLIP_MASK);
+        const __m512i popcnts_vec = _mm512_popcnt_epi64(loaded_vec);
+        const __m256i half_sum = _mm256_add_epi64(_mm512_maskz_extracti64x4_epi64(0xF, popcnts_vec, 0), 
+                                                  _mm512_maskz_extracti64x4_epi64(0xF, popcnts_vec, 1));
+        const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(half_sum), _mm256_extracti128_si256(half_sum, 1));
+        const uint64_t num_ones = static_cast<uint64_t>(_mm_cvtsi128_si64(sum)) + 
+                                  static_cast<uint64_t>(_mm_extract_epi64(sum, 1));
+        if (k < num_ones) {
+            break;
+        }
+        k -= num_ones;
+    }
+    if (i == num_blocks) {
+        return num_blocks * BLOCK_WIDTH;
+    }
 
-    packed_int_view(const packed_int_view &) = default;
+    const __mmask8 load_mask = num_blocks - i >= 8 ? 
+        static_cast<__mmask8>(0xFF) : static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(num_blocks - i)));
+    const __m512i loaded_vec = _mm512_maskz_xor_epi64(
+        load_mask, _mm512_maskz_loadu_epi64(load_mask, blocks + i), FLIP_MASK);
 
-    packed_int_view(uint32_t width, block_type *blocks, size_type num_elems) noexcept
-        : blocks_(blocks), num_elems_(num_elems), width_(width) { }
+    __m512i popcnts_vec = _mm512_popcnt_epi64(loaded_vec);
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 1));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 2));
+    popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_maskz_alignr_epi64(0xFF, popcnts_vec, ZERO, 8 - 4));
 
-    packed_int_view &operator=(const packed_int_view &) = default;
+    const __mmask8 cmp_mask = _mm512_cmp_epu64_mask(_mm512_set1_epi64(k + 1), popcnts_vec, _MM_CMPINT_LE);
+    if (cmp_mask == 0) {
+        return num_blocks * BLOCK_WIDTH;
+    }
 
-    _YAEF_ATTR_NODISCARD size_type size() const noexcept { return num_elems_; }
-    _YAEF_ATTR_NODISCARD bool empty() const noexcept { return size() == 0; }
-    _YAEF_ATTR_NODISCARD uint32_t width() const noexcept { return width_; }
-    _YAEF_ATTR_NODISCARD const block_type *blocks() const noexcept { return blocks_; }
-    _YAEF_ATTR_NODISCARD block_type *blocks() noexcept { return blocks_; }
+    uint64_t popcnts[8];
+    _mm512_storeu_si512(popcnts, popcnts_vec);
+    const uint32_t lane_idx = count_trailing_zero(static_cast<uint64_t>(cmp_mask));
+    const uint64_t prv_num_ones = lane_idx == 0 ? 0 : popcnts[lane_idx - 1];
+    const uint64_t block = BitType ? blocks[i + lane_idx] : ~blocks[i + lane_idx];
+    return (i + lane_idx) * BLOCK_WIDTH + select_one(block, k - prv_num_ones);
+}
 
-    _YAEF_ATTR_NODISCARD size_type num_blocks() const noexcept { 
-        return bits64::idiv_ceil(num_elems_ * width_, BLOCK_WIDTH); 
-    }
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
+select_one_blocks_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_avx512<true>(blocks, num_blocks, k);
+}
 
-    _YAEF_ATTR_NODISCARD value_type limit_min() const { return 0; }
-    
-    _YAEF_ATTR_NODISCARD value_type limit_max() const {
-        if (_YAEF_UNLIKELY(width() == sizeof(value_type) * CHAR_BIT)) { 
-            return std::numeric_limits<value_type>::max(); 
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
+select_zero_blocks_avx512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_avx512<false>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
+popcount_range_avx512(const uint64_t *blocks, size_t n) {
+    __m512i popcnts_vecs[4] = {
+        _mm512_setzero_si512(), _mm512_setzero_si512(), 
+        _mm512_setzero_si512(), _mm512_setzero_si512()
+    };
+
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        for (size_t j = 0; j < 4; ++j) {
+            const __m512i loaded_vec = _mm512_loadu_si512(blocks + i + j * 8);
+            popcnts_vecs[j] = _mm512_add_epi64(popcnts_vecs[j], _mm512_popcnt_epi64(loaded_vec));
         }
-        return (static_cast<value_type>(1) << width()) - 1;
+    }
+    for (; i + 8 <= n; i += 8) {
+        const __m512i loaded_vec = _mm512_loadu_si512(blocks + i);
+        popcnts_vecs[0] = _mm512_add_epi64(popcnts_vecs[0], _mm512_popcnt_epi64(loaded_vec));
+    }
+    if (i < n) {
+        const __mmask8 load_mask = static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(n - i)));
+        const __m512i loaded_vec = _mm512_maskz_loadu_epi64(load_mask, blocks + i);
+        popcnts_vecs[1] = _mm512_add_epi64(popcnts_vecs[1], _mm512_popcnt_epi64(loaded_vec));
     }
 
-    _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
-        return sizeof(block_type) * num_blocks();
+    const __m512i popcnts_vec = _mm512_add_epi64(
+        _mm512_add_epi64(popcnts_vecs[0], popcnts_vecs[1]), 
+        _mm512_add_epi64(popcnts_vecs[2], popcnts_vecs[3]));
+    uint64_t popcnts[8];
+    _mm512_storeu_si512(popcnts, popcnts_vec);
+    size_t res = 0;
+    for (size_t j = 0; j < 8; ++j) {
+        res += popcnts[j];
     }
+    return res;
+}
 
-    void fill(value_type value) {
-        if (_YAEF_UNLIKELY(value == limit_min())) {
-            clear_all_bits();
-            return;
-        }
-        if (_YAEF_UNLIKELY(value == limit_max())) {
-            set_all_bits();
-            return;
-        }
-        for (size_type i = 0; i < size(); ++i) {
-            set_value(i, value);
-        }
+// decodes a group of packed ints into the 8 lanes, a whole group is gathered by a single vpermb
+struct group_unpacker_avx512 {
+    __m512i byte_indices_vec;
+    __m512i shifts_vec;
+    __m512i mask_vec;
+
+    // the tables are computed in registers, so that a short scan does not pay for building them
+    _YAEF_ATTR_TARGET_AVX512 explicit group_unpacker_avx512(uint32_t width) noexcept {
+        _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+        const __m512i bit_offsets_vec = _mm512_mullo_epi64(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), 
+                                                           _mm512_set1_epi64(width));
+        // lane j takes the bytes [bit_offset / 8, bit_offset / 8 + 8)
+        byte_indices_vec = _mm512_add_epi64(
+            _mm512_mullo_epi64(_mm512_maskz_srli_epi64(0xFF, bit_offsets_vec, 3), _mm512_set1_epi64(0x0101010101010101)),
+            _mm512_set1_epi64(0x0706050403020100));
+        shifts_vec = _mm512_and_si512(bit_offsets_vec, _mm512_set1_epi64(7));
+        mask_vec = _mm512_set1_epi64(static_cast<long long>(make_mask_lsb1(width)));
     }
 
-    void prefetch_for_read(size_type first, size_type last) const noexcept {
-        _YAEF_ASSERT(first <= last);
-        _YAEF_ASSERT(last <= size());
+    _YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX512 
+    __m512i unpack(const uint8_t *src) const noexcept {
+        __m512i vec = _mm512_loadu_si512(src);
+        vec = _mm512_maskz_permutexvar_epi8(~static_cast<__mmask64>(0), byte_indices_vec, vec);
+        return _mm512_and_si512(_mm512_maskz_srlv_epi64(0xFF, vec, shifts_vec), mask_vec);
+    }
+};
 
-        const size_type first_block_index = first * width() / BLOCK_WIDTH;
-        const size_type last_block_index = last * width() / BLOCK_WIDTH;
-        const size_type num_blocks = last_block_index - first_block_index + 1;
-        constexpr size_type STEP = 64 / sizeof(block_type);
-        for (size_type i = 0; i < num_blocks; i += STEP) {
-            prefetch_read(blocks() + first_block_index + i);
+_YAEF_ATTR_TARGET_AVX512 inline void
+unpack_ints_avx512(const uint8_t *src, uint32_t width, size_t num_groups, uint64_t *out) {
+    const group_unpacker_avx512 unpacker{width};
+    for (size_t g = 0; g < num_groups; ++g) {
+        _mm512_storeu_si512(out, unpacker.unpack(src));
+        src += width;
+        out += PACKED_GROUP_SIZE;
+    }
+}
+
+// values are compared as `value - min <= range` in unsigned arithmetic, so the values 
+// below `min` wrap around and fail as well.
+_YAEF_ATTR_TARGET_AVX512 inline void
+scan_ints_avx512(const uint8_t *src, uint32_t width, size_t num_groups, 
+                 uint64_t min, uint64_t range, uint8_t *out) {
+    const group_unpacker_avx512 unpacker{width};
+    const __m512i min_vec = _mm512_set1_epi64(static_cast<long long>(min));
+    const __m512i range_vec = _mm512_set1_epi64(static_cast<long long>(range));
+    for (size_t g = 0; g < num_groups; ++g) {
+        const __m512i vec = _mm512_sub_epi64(unpacker.unpack(src), min_vec);
+        out[g] = static_cast<uint8_t>(_mm512_cmple_epu64_mask(vec, range_vec));
+        src += width;
+    }
+}
+
+// the lanes before `first` are masked out of the compare, and a match after `last` 
+// is clamped to `last`, so the unaligned ends need no scalar loop
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline size_t
+find_ints_not_less_avx512(const uint8_t *src, uint32_t width, size_t first, size_t last, uint64_t target) {
+    const group_unpacker_avx512 unpacker{width};
+    const __m512i target_vec = _mm512_set1_epi64(static_cast<long long>(target));
+    size_t i = first / PACKED_GROUP_SIZE * PACKED_GROUP_SIZE;
+    __mmask8 lanes = static_cast<__mmask8>(0xFF << (first % PACKED_GROUP_SIZE));
+    src += first / PACKED_GROUP_SIZE * width;
+    for (; i < last; i += PACKED_GROUP_SIZE) {
+        const __mmask8 matches = _mm512_mask_cmpge_epu64_mask(lanes, unpacker.unpack(src), target_vec);
+        if (matches != 0) {
+            return std::min(i + count_trailing_zero(matches), last);
+        }
+        lanes = 0xFF;
+        src += width;
+    }
+    return last;
+}
+
+_YAEF_ATTR_TARGET_AVX512 inline uint64_t
+unpack_prefix_sum_ints_avx512(const uint8_t *src, uint32_t width, size_t num_groups, 
+                              uint64_t init, uint64_t *out) {
+    const group_unpacker_avx512 unpacker{width};
+    const __m512i ZERO = _mm512_setzero_si512();
+    const __m512i LAST_LANE = _mm512_set1_epi64(7);
+    __m512i carry_vec = _mm512_set1_epi64(static_cast<long long>(init));
+    for (size_t g = 0; g < num_groups; ++g) {
+        __m512i vec = unpacker.unpack(src);
+        vec = _mm512_add_epi64(vec, _mm512_maskz_alignr_epi64(0xFF, vec, ZERO, 8 - 1));
+        vec = _mm512_add_epi64(vec, _mm512_maskz_alignr_epi64(0xFF, vec, ZERO, 8 - 2));
+        vec = _mm512_add_epi64(vec, _mm512_maskz_alignr_epi64(0xFF, vec, ZERO, 8 - 4));
+        vec = _mm512_add_epi64(vec, carry_vec);
+        _mm512_storeu_si512(out, vec);
+        carry_vec = _mm512_maskz_permutexvar_epi64(0xFF, LAST_LANE, vec);
+        src += width;
+        out += PACKED_GROUP_SIZE;
+    }
+    return num_groups != 0 ? out[-1] : init;
+}
+
+// the previous values of a vector are its lanes shifted up by one, with the last lane 
+// of the previous vector shifted in
+_YAEF_ATTR_TARGET_AVX512 inline void
+delta_values_avx512(uint64_t *values, size_t n, uint64_t prev) {
+    __m512i prev_vec = _mm512_set1_epi64(static_cast<long long>(prev));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m512i vec = _mm512_loadu_si512(values + i);
+        _mm512_storeu_si512(values + i, _mm512_sub_epi64(vec, _mm512_maskz_alignr_epi64(0xFF, vec, prev_vec, 8 - 1)));
+        prev_vec = vec;
+    }
+    if (i < n) {
+        const __mmask8 tail_mask = static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(n - i)));
+        const __m512i vec = _mm512_maskz_loadu_epi64(tail_mask, values + i);
+        _mm512_mask_storeu_epi64(values + i, tail_mask, 
+                                 _mm512_sub_epi64(vec, _mm512_maskz_alignr_epi64(0xFF, vec, prev_vec, 8 - 1)));
+    }
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 inline uint64_t
+max_ints_avx512(const uint8_t *src, uint32_t width, size_t num_groups) {
+    const group_unpacker_avx512 unpacker{width};
+    __m512i max_vec = _mm512_setzero_si512();
+    for (size_t g = 0; g < num_groups; ++g) {
+        max_vec = _mm512_maskz_max_epu64(0xFF, max_vec, unpacker.unpack(src));
+        src += width;
+    }
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, max_vec);
+    return *std::max_element(lanes, lanes + 8);
+}
+
+template<bitwise_op Op>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX512 
+__m512i apply_bitwise_op_avx512(__m512i lhs, __m512i rhs) noexcept {
+    switch (Op) {
+    case bitwise_op::bit_and : return _mm512_and_si512(lhs, rhs);
+    case bitwise_op::bit_or  : return _mm512_or_si512(lhs, rhs);
+    case bitwise_op::bit_xor : return _mm512_xor_si512(lhs, rhs);
+    default                  : return _mm512_maskz_andnot_epi64(0xFF, rhs, lhs);
+    }
+}
+
+struct bitwise_blocks_avx512_kernel {
+    template<bitwise_op Op, bool Count>
+    _YAEF_ATTR_TARGET_AVX512 static size_t run(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n) {
+        __m512i popcnts_vec = _mm512_setzero_si512();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            const __m512i vec = apply_bitwise_op_avx512<Op>(_mm512_loadu_si512(lhs + i), _mm512_loadu_si512(rhs + i));
+            _mm512_storeu_si512(dst + i, vec);
+            if (Count) { popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_popcnt_epi64(vec)); }
+        }
+        if (i < n) {
+            const __mmask8 tail_mask = static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(n - i)));
+            const __m512i vec = apply_bitwise_op_avx512<Op>(_mm512_maskz_loadu_epi64(tail_mask, lhs + i), 
+                                                            _mm512_maskz_loadu_epi64(tail_mask, rhs + i));
+            _mm512_mask_storeu_epi64(dst + i, tail_mask, vec);
+            if (Count) { popcnts_vec = _mm512_add_epi64(popcnts_vec, _mm512_popcnt_epi64(vec)); }
+        }
+        if (!Count) {
+            return 0;
+        }
+        uint64_t popcnts[8];
+        _mm512_storeu_si512(popcnts, popcnts_vec);
+        size_t res = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            res += popcnts[j];
         }
+        return res;
     }
+};
 
-    void prefetch_for_write(size_type first, size_type last) noexcept {
-        _YAEF_ASSERT(first <= last);
-        _YAEF_ASSERT(last <= size());
+_YAEF_ATTR_NODISCARD inline size_t 
+bitwise_blocks_avx512(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n, 
+                      bitwise_op op, bool count) {
+    return dispatch_bitwise_kernel<bitwise_blocks_avx512_kernel>(dst, lhs, rhs, n, op, count);
+}
 
-        const size_type first_block_index = first * width() / BLOCK_WIDTH;
-        const size_type last_block_index = last * width() / BLOCK_WIDTH;
-        const size_type num_blocks = last_block_index - first_block_index + 1;
-        constexpr size_type STEP = 64 / sizeof(block_type);
-        for (size_type i = 0; i < num_blocks; i += STEP) {
-            prefetch_write(blocks() + first_block_index + i);
-        }
+// the lanes of the 512 bits that contain a `Bit`
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX512 
+__mmask8 lanes_with_bit_avx512(__mmask8 load_mask, const uint64_t *blocks) noexcept {
+    const __m512i empty_vec = _mm512_set1_epi64(Bit ? 0 : -1);
+    const __m512i vec = _mm512_mask_loadu_epi64(empty_vec, load_mask, blocks);
+    return _mm512_cmpneq_epu64_mask(vec, empty_vec);
+}
+
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 size_t find_block_with_bit_avx512_impl(const uint64_t *blocks, size_t n) {
+    for (size_t i = 0; i < n; i += 8) {
+        const __mmask8 load_mask = static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(std::min<size_t>(n - i, 8))));
+        const __mmask8 lanes = lanes_with_bit_avx512<Bit>(load_mask, blocks + i);
+        if (lanes != 0) { return i + count_trailing_zero(static_cast<uint64_t>(lanes)); }
     }
+    return n;
+}
 
-    _YAEF_ATTR_NODISCARD bit_view to_bit_view() noexcept;
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 size_t rfind_block_with_bit_avx512_impl(const uint64_t *blocks, size_t n) {
+    for (size_t i = n; i > 0; ) {
+        const size_t num = std::min<size_t>(i, 8);
+        i -= num;
+        const __mmask8 load_mask = static_cast<__mmask8>(make_mask_lsb1(static_cast<uint32_t>(num)));
+        const __mmask8 lanes = lanes_with_bit_avx512<Bit>(load_mask, blocks + i);
+        if (lanes != 0) { return i + 63 - count_leading_zero(static_cast<uint64_t>(lanes)); }
+    }
+    return n;
+}
+
+_YAEF_ATTR_NODISCARD inline size_t find_block_with_bit_avx512(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? find_block_with_bit_avx512_impl<true>(blocks, n) : find_block_with_bit_avx512_impl<false>(blocks, n);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t rfind_block_with_bit_avx512(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? rfind_block_with_bit_avx512_impl<true>(blocks, n) : rfind_block_with_bit_avx512_impl<false>(blocks, n);
+}
+
+// compress the positions of a 16-bit (32-bit indices) or 8-bit (64-bit indices) chunk. the
+// full-width store is used if it stays before the last index, the exact one otherwise.
+_YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX512 void 
+compress_chunk_positions_avx512(uint32_t *out, uint64_t chunk, uint32_t offset, bool full_store) noexcept {
+    const __mmask16 mask = static_cast<__mmask16>(chunk);
+    const __m512i vec = _mm512_add_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+                                         _mm512_set1_epi32(static_cast<int32_t>(offset)));
+    if (full_store) {
+        _mm512_storeu_si512(out, _mm512_maskz_compress_epi32(mask, vec));
+    } else {
+        _mm512_mask_compressstoreu_epi32(out, mask, vec);
+    }
+}
+
+_YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX512 void 
+compress_chunk_positions_avx512(uint64_t *out, uint64_t chunk, uint64_t offset, bool full_store) noexcept {
+    const __mmask8 mask = static_cast<__mmask8>(chunk);
+    const __m512i vec = _mm512_add_epi64(_mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0),
+                                         _mm512_set1_epi64(static_cast<int64_t>(offset)));
+    if (full_store) {
+        _mm512_storeu_si512(out, _mm512_maskz_compress_epi64(mask, vec));
+    } else {
+        _mm512_mask_compressstoreu_epi64(out, mask, vec);
+    }
+}
+
+template<bool Bit, typename T>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX512 size_t 
+decode_bits_avx512_impl(const uint64_t *blocks, size_t n, T *out, size_t out_capacity, T index_offset) {
+    constexpr uint32_t CHUNK_WIDTH = 64 / sizeof(T);
+    constexpr uint32_t SPARSE_BLOCK_POPCNT = 4;
+    size_t num_decoded = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t block = Bit ? blocks[i] : ~blocks[i];
+        if (block == 0) { continue; }
+        const T block_offset = index_offset + static_cast<T>(i * 64);
+        const uint32_t block_popcnt = popcount(block);
+        // sparse blocks are faster to decode one bit at a time
+        if (block_popcnt < SPARSE_BLOCK_POPCNT) {
+            num_decoded += decode_bits_scalar_impl<true>(&block, 1, out + num_decoded, block_offset);
+            continue;
+        }
+        const bool full_store = num_decoded + block_popcnt + CHUNK_WIDTH <= out_capacity;
+        for (uint32_t j = 0; j < 64; j += CHUNK_WIDTH) {
+            const uint64_t chunk = extract_first_bits(block >> j, CHUNK_WIDTH);
+            compress_chunk_positions_avx512(out + num_decoded, chunk, block_offset + static_cast<T>(j), full_store);
+            num_decoded += popcount(chunk);
+        }
+    }
+    return num_decoded;
+}
+
+template<typename T>
+_YAEF_ATTR_NODISCARD inline size_t 
+decode_bits_avx512(const uint64_t *blocks, size_t n, bool bit, T *out, size_t out_capacity, T index_offset) {
+    return bit ? decode_bits_avx512_impl<true>(blocks, n, out, out_capacity, index_offset) : 
+                 decode_bits_avx512_impl<false>(blocks, n, out, out_capacity, index_offset);
+}
+
+// the inverse of `unpack_ints_avx512`. when width >= 8, two values of the same parity never
+// share a byte, so the group is assembled by one vpermb for the even lanes and one for the
+// odd lanes. narrower groups fit in a word and are simply or-ed together.
+_YAEF_ATTR_TARGET_AVX512 inline void
+pack_ints_avx512(const uint64_t *src, uint32_t width, size_t num_groups, uint8_t *dst) {
+    _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+    const __m512i mask_vec = _mm512_set1_epi64(static_cast<long long>(make_mask_lsb1(width)));
+    const __mmask64 store_mask = make_mask_lsb1(width);
+
+    if (width < 8) {
+        uint64_t shifts[8];
+        for (uint32_t j = 0; j < PACKED_GROUP_SIZE; ++j) {
+            shifts[j] = j * width;
+        }
+        const __m512i shifts_vec = _mm512_loadu_si512(shifts);
+        for (size_t g = 0; g < num_groups; ++g) {
+            __m512i vec = _mm512_and_si512(_mm512_loadu_si512(src), mask_vec);
+            vec = _mm512_maskz_sllv_epi64(0xFF, vec, shifts_vec);
+            const __m256i half = _mm256_or_si256(_mm512_maskz_extracti64x4_epi64(0xF, vec, 0), 
+                                                 _mm512_maskz_extracti64x4_epi64(0xF, vec, 1));
+            const __m128i quarter = _mm_or_si128(_mm256_castsi256_si128(half), 
+                                                 _mm256_extracti128_si256(half, 1));
+            const uint64_t group = static_cast<uint64_t>(_mm_cvtsi128_si64(quarter)) | 
+                                   static_cast<uint64_t>(_mm_extract_epi64(quarter, 1));
+            memcpy(dst, &group, width);
+            src += PACKED_GROUP_SIZE;
+            dst += width;
+        }
+        return;
+    }
+
+    uint8_t byte_indices[2][64] = {};
+    __mmask64 byte_masks[2] = {0, 0};
+    uint64_t shifts[8];
+    for (uint32_t j = 0; j < PACKED_GROUP_SIZE; ++j) {
+        const uint32_t bit_offset = j * width;
+        const uint32_t first_byte = bit_offset / 8, 
+                       last_byte = (bit_offset + width - 1) / 8;
+        for (uint32_t b = first_byte; b <= last_byte; ++b) {
+            byte_indices[j % 2][b] = static_cast<uint8_t>(j * 8 + b - first_byte);
+            byte_masks[j % 2] |= static_cast<__mmask64>(1) << b;
+        }
+        shifts[j] = bit_offset % 8;
+    }
+    const __m512i even_indices_vec = _mm512_loadu_si512(byte_indices[0]);
+    const __m512i odd_indices_vec = _mm512_loadu_si512(byte_indices[1]);
+    const __m512i shifts_vec = _mm512_loadu_si512(shifts);
+
+    for (size_t g = 0; g < num_groups; ++g) {
+        __m512i vec = _mm512_and_si512(_mm512_loadu_si512(src), mask_vec);
+        vec = _mm512_maskz_sllv_epi64(0xFF, vec, shifts_vec);
+        const __m512i even = _mm512_maskz_permutexvar_epi8(byte_masks[0], even_indices_vec, vec);
+        const __m512i odd = _mm512_maskz_permutexvar_epi8(byte_masks[1], odd_indices_vec, vec);
+        _mm512_mask_storeu_epi8(dst, store_mask, _mm512_or_si512(even, odd));
+        src += PACKED_GROUP_SIZE;
+        dst += width;
+    }
+}
+#endif
+
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX2
+// per-lane popcount of 4 words, by looking up nibbles with vpshufb and summing bytes with vpsadbw
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+__m256i popcount_epi64_avx2(__m256i vec) noexcept {
+    const __m256i NIBBLE_POPCNT_LUT = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i LOW_NIBBLE_MASK = _mm256_set1_epi8(0x0F);
+
+    const __m256i lo = _mm256_and_si256(vec, LOW_NIBBLE_MASK);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(vec, 4), LOW_NIBBLE_MASK);
+    const __m256i byte_cnts = _mm256_add_epi8(_mm256_shuffle_epi8(NIBBLE_POPCNT_LUT, lo),
+                                              _mm256_shuffle_epi8(NIBBLE_POPCNT_LUT, hi));
+    return _mm256_sad_epu8(byte_cnts, _mm256_setzero_si256());
+}
+
+// inclusive prefix sum over the 4 lanes
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+__m256i prefix_sum_epi64_avx2(__m256i vec) noexcept {
+    vec = _mm256_add_epi64(vec, _mm256_slli_si256(vec, 8));
+    const __m256i lower_half_sum = _mm256_permute4x64_epi64(vec, _MM_SHUFFLE(1, 1, 1, 1));
+    return _mm256_add_epi64(vec, _mm256_blend_epi32(_mm256_setzero_si256(), lower_half_sum, 0xF0));
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+uint64_t reduce_add_epi64_avx2(__m256i vec) noexcept {
+    const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(vec), _mm256_extracti128_si256(vec, 1));
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(sum)) + static_cast<uint64_t>(_mm_extract_epi64(sum, 1));
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+popcount_blocks_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+
+    k = std::min(k, num_blocks * BLOCK_WIDTH);
+    const size_t num_skipped_blocks = k / BLOCK_WIDTH,
+                 num_rem_bits = k % BLOCK_WIDTH;
+
+    __m256i popcnts_vec = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= num_skipped_blocks; i += 4) {
+        const __m256i loaded_vec = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i));
+        popcnts_vec = _mm256_add_epi64(popcnts_vec, popcount_epi64_avx2(loaded_vec));
+    }
+
+    size_t num_ones = reduce_add_epi64_avx2(popcnts_vec);
+    for (; i < num_skipped_blocks; ++i) {
+        num_ones += popcount(blocks[i]);
+    }
+    if (num_rem_bits != 0) {
+        num_ones += popcount(extract_first_bits(blocks[num_skipped_blocks], num_rem_bits));
+    }
+    return num_ones;
+}
+
+template<bool BitType>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_blocks_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+    const __m256i FLIP_MASK = BitType ? _mm256_setzero_si256() : _mm256_set1_epi64x(-1);
+
+    if (_YAEF_UNLIKELY(k + 1 == 0)) {
+        return static_cast<size_t>(-1);
+    }
+
+    // whole cache lines are skipped with the popcnt instruction, which outruns the shuffle 
+    // based popcount of avx2. the prefix sums are only computed for the line holding the target.
+    size_t i = 0;
+    for (; i + 8 <= num_blocks; i += 8) {
+        uint64_t num_ones = 0;
+        for (size_t j = 0; j < 8; ++j) {
+            num_ones += popcount(BitType ? blocks[i + j] : ~blocks[i + j]);
+        }
+        if (k < num_ones) {
+            break;
+        }
+        k -= num_ones;
+    }
+
+    for (; i + 4 <= num_blocks; i += 4) {
+        const __m256i loaded_vec = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i)), FLIP_MASK);
+        const __m256i popcnts_vec = prefix_sum_epi64_avx2(popcount_epi64_avx2(loaded_vec));
+        const uint64_t num_ones = static_cast<uint64_t>(_mm256_extract_epi64(popcnts_vec, 3));
+        if (k >= num_ones) {
+            k -= num_ones;
+            continue;
+        }
+
+        // k < num_ones <= 256 here, so the signed comparison is safe
+        const __m256i index_vec = _mm256_set1_epi64x(static_cast<int64_t>(k));
+        const uint32_t cmp_mask = _mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(popcnts_vec, index_vec)));
+        const uint32_t lane_idx = count_trailing_zero(cmp_mask);
+
+        uint64_t popcnts[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(popcnts), popcnts_vec);
+        const uint64_t prv_num_ones = lane_idx == 0 ? 0 : popcnts[lane_idx - 1];
+        const uint64_t block = BitType ? blocks[i + lane_idx] : ~blocks[i + lane_idx];
+        return (i + lane_idx) * BLOCK_WIDTH + select_one(block, k - prv_num_ones);
+    }
+
+    for (; i < num_blocks; ++i) {
+        const uint64_t block = BitType ? blocks[i] : ~blocks[i];
+        const uint32_t num_ones = popcount(block);
+        if (k < num_ones) {
+            return i * BLOCK_WIDTH + select_one(block, k);
+        }
+        k -= num_ones;
+    }
+    return num_blocks * BLOCK_WIDTH;
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_one_blocks_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_avx2<true>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_zero_blocks_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_avx2<false>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+__m256i load_vec_avx2(const uint64_t *p, size_t vec_index = 0) noexcept {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p) + vec_index);
+}
+
+// carry-save adder over bit-sliced counters, used by Harley-Seal popcount
+_YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+void carry_save_add_avx2(__m256i &high, __m256i &low, __m256i a, __m256i b, __m256i c) noexcept {
+    const __m256i u = _mm256_xor_si256(a, b);
+    high = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(u, c));
+    low = _mm256_xor_si256(u, c);
+}
+
+// Harley-Seal popcount, reference: Mula, Kurz and Lemire, "Faster Population Counts
+// Using AVX2 Instructions". 16 vectors are folded by carry-save adders, so the nibble
+// lookups run once per 16 vectors instead of once per vector.
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+popcount_range_avx2(const uint64_t *blocks, size_t n) {
+    constexpr size_t WORDS_PER_VEC = sizeof(__m256i) / sizeof(uint64_t);
+
+    const __m256i ZERO = _mm256_setzero_si256();
+    __m256i total = ZERO, ones = ZERO, twos = ZERO, fours = ZERO, eights = ZERO, sixteens = ZERO;
+    __m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+
+    size_t i = 0;
+    for (; i + 16 * WORDS_PER_VEC <= n; i += 16 * WORDS_PER_VEC) {
+        const uint64_t *chunk = blocks + i;
+        carry_save_add_avx2(twos_a, ones, ones, load_vec_avx2(chunk, 0), load_vec_avx2(chunk, 1));
+        carry_save_add_avx2(twos_b, ones, ones, load_vec_avx2(chunk, 2), load_vec_avx2(chunk, 3));
+        carry_save_add_avx2(fours_a, twos, twos, twos_a, twos_b);
+        carry_save_add_avx2(twos_a, ones, ones, load_vec_avx2(chunk, 4), load_vec_avx2(chunk, 5));
+        carry_save_add_avx2(twos_b, ones, ones, load_vec_avx2(chunk, 6), load_vec_avx2(chunk, 7));
+        carry_save_add_avx2(fours_b, twos, twos, twos_a, twos_b);
+        carry_save_add_avx2(eights_a, fours, fours, fours_a, fours_b);
+        carry_save_add_avx2(twos_a, ones, ones, load_vec_avx2(chunk, 8), load_vec_avx2(chunk, 9));
+        carry_save_add_avx2(twos_b, ones, ones, load_vec_avx2(chunk, 10), load_vec_avx2(chunk, 11));
+        carry_save_add_avx2(fours_a, twos, twos, twos_a, twos_b);
+        carry_save_add_avx2(twos_a, ones, ones, load_vec_avx2(chunk, 12), load_vec_avx2(chunk, 13));
+        carry_save_add_avx2(twos_b, ones, ones, load_vec_avx2(chunk, 14), load_vec_avx2(chunk, 15));
+        carry_save_add_avx2(fours_b, twos, twos, twos_a, twos_b);
+        carry_save_add_avx2(eights_b, fours, fours, fours_a, fours_b);
+        carry_save_add_avx2(sixteens, eights, eights, eights_a, eights_b);
+        total = _mm256_add_epi64(total, popcount_epi64_avx2(sixteens));
+    }
+
+    total = _mm256_slli_epi64(total, 4);
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_epi64_avx2(eights), 3));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_epi64_avx2(fours), 2));
+    total = _mm256_add_epi64(total, _mm256_slli_epi64(popcount_epi64_avx2(twos), 1));
+    total = _mm256_add_epi64(total, popcount_epi64_avx2(ones));
+    for (; i + WORDS_PER_VEC <= n; i += WORDS_PER_VEC) {
+        total = _mm256_add_epi64(total, popcount_epi64_avx2(load_vec_avx2(blocks + i)));
+    }
+
+    size_t res = reduce_add_epi64_avx2(total);
+    for (; i < n; ++i) {
+        res += popcount(blocks[i]);
+    }
+    return res;
+}
+
+// decodes a group of packed ints into two vectors of 4 lanes. vpshufb cannot cross 128-bit 
+// lanes, so each lane is loaded from the first byte of a value pair, and both values of the 
+// pair are within the 16 loaded bytes.
+struct group_unpacker_avx2 {
+    uint32_t pair_offsets[4];
+    __m256i  byte_indices_vecs[2];
+    __m256i  shifts_vecs[2];
+    __m256i  mask_vec;
+
+    _YAEF_ATTR_TARGET_AVX2 explicit group_unpacker_avx2(uint32_t width) noexcept {
+        _YAEF_ASSERT(width > 0 && width <= PACKED_GROUP_MAX_WIDTH);
+        uint8_t byte_indices[64];
+        uint64_t shifts[8];
+        for (uint32_t j = 0; j < PACKED_GROUP_SIZE; ++j) {
+            const uint32_t bit_offset = j * width;
+            if (j % 2 == 0) {
+                pair_offsets[j / 2] = bit_offset / 8;
+            }
+            for (uint32_t b = 0; b < 8; ++b) {
+                byte_indices[j * 8 + b] = static_cast<uint8_t>(bit_offset / 8 - pair_offsets[j / 2] + b);
+            }
+            shifts[j] = bit_offset % 8;
+        }
+        byte_indices_vecs[0] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(byte_indices));
+        byte_indices_vecs[1] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(byte_indices + 32));
+        shifts_vecs[0] = load_vec_avx2(shifts, 0);
+        shifts_vecs[1] = load_vec_avx2(shifts, 1);
+        mask_vec = _mm256_set1_epi64x(static_cast<long long>(make_mask_lsb1(width)));
+    }
+
+    // decode the values [v * 4, v * 4 + 4) of the group
+    _YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+    __m256i unpack(const uint8_t *src, uint32_t v) const noexcept {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + pair_offsets[v * 2]));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + pair_offsets[v * 2 + 1]));
+        __m256i vec = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        vec = _mm256_shuffle_epi8(vec, byte_indices_vecs[v]);
+        return _mm256_and_si256(_mm256_srlv_epi64(vec, shifts_vecs[v]), mask_vec);
+    }
+};
+
+_YAEF_ATTR_TARGET_AVX2 inline void
+unpack_ints_avx2(const uint8_t *src, uint32_t width, size_t num_groups, uint64_t *out) {
+    const group_unpacker_avx2 unpacker{width};
+    for (size_t g = 0; g < num_groups; ++g) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), unpacker.unpack(src, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 4), unpacker.unpack(src, 1));
+        src += width;
+        out += PACKED_GROUP_SIZE;
+    }
+}
+
+// avx2 has no unsigned 64-bit compare, flipping the sign bits turns it into a signed one
+_YAEF_ATTR_TARGET_AVX2 inline void
+scan_ints_avx2(const uint8_t *src, uint32_t width, size_t num_groups, 
+               uint64_t min, uint64_t range, uint8_t *out) {
+    const group_unpacker_avx2 unpacker{width};
+    const __m256i sign_vec = _mm256_set1_epi64x(static_cast<long long>(1ULL << 63));
+    const __m256i min_vec = _mm256_set1_epi64x(static_cast<long long>(min));
+    const __m256i range_vec = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(range)), sign_vec);
+    for (size_t g = 0; g < num_groups; ++g) {
+        uint32_t mismatches = 0;
+        for (uint32_t v = 0; v < 2; ++v) {
+            __m256i vec = _mm256_sub_epi64(unpacker.unpack(src, v), min_vec);
+            vec = _mm256_cmpgt_epi64(_mm256_xor_si256(vec, sign_vec), range_vec);
+            mismatches |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(vec))) << (v * 4);
+        }
+        out[g] = static_cast<uint8_t>(~mismatches);
+        src += width;
+    }
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+find_ints_not_less_avx2(const uint8_t *src, uint32_t width, size_t first, size_t last, uint64_t target) {
+    const group_unpacker_avx2 unpacker{width};
+    const __m256i sign_vec = _mm256_set1_epi64x(static_cast<long long>(1ULL << 63));
+    const __m256i target_vec = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(target)), sign_vec);
+    size_t i = first / PACKED_GROUP_SIZE * PACKED_GROUP_SIZE;
+    uint32_t lanes = (0xFFu << (first % PACKED_GROUP_SIZE)) & 0xFF;
+    src += first / PACKED_GROUP_SIZE * width;
+    for (; i < last; i += PACKED_GROUP_SIZE) {
+        uint32_t less = 0;
+        for (uint32_t v = 0; v < 2; ++v) {
+            const __m256i vec = _mm256_cmpgt_epi64(target_vec, _mm256_xor_si256(unpacker.unpack(src, v), sign_vec));
+            less |= static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(vec))) << (v * 4);
+        }
+        const uint32_t matches = ~less & lanes;
+        if (matches != 0) {
+            return std::min<size_t>(i + count_trailing_zero(matches), last);
+        }
+        lanes = 0xFF;
+        src += width;
+    }
+    return last;
+}
+
+_YAEF_ATTR_TARGET_AVX2 inline uint64_t
+unpack_prefix_sum_ints_avx2(const uint8_t *src, uint32_t width, size_t num_groups, 
+                            uint64_t init, uint64_t *out) {
+    const group_unpacker_avx2 unpacker{width};
+    __m256i carry_vec = _mm256_set1_epi64x(static_cast<long long>(init));
+    for (size_t g = 0; g < num_groups; ++g) {
+        for (uint32_t v = 0; v < 2; ++v) {
+            const __m256i vec = _mm256_add_epi64(prefix_sum_epi64_avx2(unpacker.unpack(src, v)), carry_vec);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + v * 4), vec);
+            carry_vec = _mm256_permute4x64_epi64(vec, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        src += width;
+        out += PACKED_GROUP_SIZE;
+    }
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(_mm256_castsi256_si128(carry_vec)));
+}
+
+_YAEF_ATTR_TARGET_AVX2 inline void
+delta_values_avx2(uint64_t *values, size_t n, uint64_t prev) {
+    __m256i prev_vec = _mm256_set1_epi64x(static_cast<long long>(prev));
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256i vec = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        // [prev[3], vec[0], vec[1], vec[2]]
+        const __m256i rotated = _mm256_permute4x64_epi64(vec, _MM_SHUFFLE(2, 1, 0, 3));
+        const __m256i prev_lanes = _mm256_blend_epi32(rotated, _mm256_permute4x64_epi64(prev_vec, _MM_SHUFFLE(3, 3, 3, 3)), 0x03);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), _mm256_sub_epi64(vec, prev_lanes));
+        prev_vec = vec;
+    }
+    delta_values_scalar(values + i, n - i, static_cast<uint64_t>(_mm256_extract_epi64(prev_vec, 3)));
+}
+
+// the values are at most 56 bits wide, so the signed compare is enough
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline uint64_t
+max_ints_avx2(const uint8_t *src, uint32_t width, size_t num_groups) {
+    const group_unpacker_avx2 unpacker{width};
+    __m256i max_vec = _mm256_setzero_si256();
+    for (size_t g = 0; g < num_groups; ++g) {
+        for (uint32_t v = 0; v < 2; ++v) {
+            const __m256i vec = unpacker.unpack(src, v);
+            max_vec = _mm256_blendv_epi8(max_vec, vec, _mm256_cmpgt_epi64(vec, max_vec));
+        }
+        src += width;
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), max_vec);
+    return *std::max_element(lanes, lanes + 4);
+}
+
+template<bitwise_op Op>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 
+__m256i apply_bitwise_op_avx2(__m256i lhs, __m256i rhs) noexcept {
+    switch (Op) {
+    case bitwise_op::bit_and : return _mm256_and_si256(lhs, rhs);
+    case bitwise_op::bit_or  : return _mm256_or_si256(lhs, rhs);
+    case bitwise_op::bit_xor : return _mm256_xor_si256(lhs, rhs);
+    default                  : return _mm256_andnot_si256(rhs, lhs);
+    }
+}
+
+struct bitwise_blocks_avx2_kernel {
+    template<bitwise_op Op, bool Count>
+    _YAEF_ATTR_TARGET_AVX2 static size_t run(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n) {
+        __m256i popcnts_vec = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const __m256i vec = apply_bitwise_op_avx2<Op>(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), vec);
+            if (Count) { popcnts_vec = _mm256_add_epi64(popcnts_vec, popcount_epi64_avx2(vec)); }
+        }
+        const size_t num_ones = Count ? reduce_add_epi64_avx2(popcnts_vec) : 0;
+        return num_ones + bitwise_blocks_scalar_kernel::run<Op, Count>(dst + i, lhs + i, rhs + i, n - i);
+    }
+};
+
+_YAEF_ATTR_NODISCARD inline size_t 
+bitwise_blocks_avx2(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n, 
+                    bitwise_op op, bool count) {
+    return dispatch_bitwise_kernel<bitwise_blocks_avx2_kernel>(dst, lhs, rhs, n, op, count);
+}
+
+// whether one of the 256 bits is a `Bit`
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 bool has_bit_avx2(__m256i vec) noexcept {
+    return Bit ? !_mm256_testz_si256(vec, vec) : !_mm256_testc_si256(vec, _mm256_set1_epi64x(-1));
+}
+
+// 512 bits are tested per iteration, the block is then located by the scalar loop
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 size_t find_block_with_bit_avx2_impl(const uint64_t *blocks, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256i vec0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i)),
+                      vec1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i + 4));
+        const __m256i merged = Bit ? _mm256_or_si256(vec0, vec1) : _mm256_and_si256(vec0, vec1);
+        if (has_bit_avx2<Bit>(merged)) { break; }
+    }
+    return i + find_block_with_bit_scalar_impl<Bit>(blocks + i, n - i);
+}
+
+template<bool Bit>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 size_t rfind_block_with_bit_avx2_impl(const uint64_t *blocks, size_t n) {
+    size_t i = n;
+    for (; i >= 8; i -= 8) {
+        const __m256i vec0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i - 8)),
+                      vec1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i - 4));
+        const __m256i merged = Bit ? _mm256_or_si256(vec0, vec1) : _mm256_and_si256(vec0, vec1);
+        if (has_bit_avx2<Bit>(merged)) { break; }
+    }
+    const size_t idx = rfind_block_with_bit_scalar_impl<Bit>(blocks, i);
+    return idx != i ? idx : n;
+}
+
+_YAEF_ATTR_NODISCARD inline size_t find_block_with_bit_avx2(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? find_block_with_bit_avx2_impl<true>(blocks, n) : find_block_with_bit_avx2_impl<false>(blocks, n);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t rfind_block_with_bit_avx2(const uint64_t *blocks, size_t n, bool bit) {
+    return bit ? rfind_block_with_bit_avx2_impl<true>(blocks, n) : rfind_block_with_bit_avx2_impl<false>(blocks, n);
+}
+
+// the positions of the 1s of each byte, padded with 0s to 8 entries
+struct byte_onebits_lut {
+    uint8_t positions[256][8];
+
+    byte_onebits_lut() noexcept {
+        for (uint32_t b = 0; b < 256; ++b) {
+            uint32_t k = 0;
+            for (uint32_t i = 0; i < 8; ++i) {
+                if ((b >> i) & 1) { positions[b][k++] = static_cast<uint8_t>(i); }
+            }
+            for (; k < 8; ++k) { positions[b][k] = 0; }
+        }
+    }
+};
+
+_YAEF_ATTR_NODISCARD inline const byte_onebits_lut &get_byte_onebits_lut() noexcept {
+    static const byte_onebits_lut lut;
+    return lut;
+}
+
+// always write 8 positions, the ones past the valid positions are overwritten later
+_YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 void 
+store_byte_positions_avx2(uint32_t *out, __m128i positions, uint32_t offset) noexcept {
+    const __m256i vec = _mm256_add_epi32(_mm256_cvtepu8_epi32(positions), _mm256_set1_epi32(static_cast<int32_t>(offset)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), vec);
+}
+
+_YAEF_ATTR_FORCEINLINE _YAEF_ATTR_TARGET_AVX2 void 
+store_byte_positions_avx2(uint64_t *out, __m128i positions, uint64_t offset) noexcept {
+    const __m256i offset_vec = _mm256_set1_epi64x(static_cast<int64_t>(offset));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), 
+                        _mm256_add_epi64(_mm256_cvtepu8_epi64(positions), offset_vec));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 4), 
+                        _mm256_add_epi64(_mm256_cvtepu8_epi64(_mm_srli_si128(positions, 4)), offset_vec));
+}
+
+// a byte is decoded at a time by looking up its positions. the stores are wider than the 
+// positions, so the blocks whose stores may go past `out + out_capacity` are decoded by the scalar loop.
+template<bool Bit, typename T>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 size_t 
+decode_bits_avx2_impl(const uint64_t *blocks, size_t n, T *out, size_t out_capacity, T index_offset) {
+    constexpr uint32_t SPARSE_BLOCK_POPCNT = 4;
+    const byte_onebits_lut &lut = get_byte_onebits_lut();
+    size_t num_decoded = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t block = Bit ? blocks[i] : ~blocks[i];
+        if (block == 0) { continue; }
+        const T block_offset = index_offset + static_cast<T>(i * 64);
+        const uint32_t block_popcnt = popcount(block);
+        // sparse blocks are faster to decode one bit at a time
+        if (block_popcnt < SPARSE_BLOCK_POPCNT || num_decoded + block_popcnt + 8 > out_capacity) {
+            num_decoded += decode_bits_scalar_impl<true>(&block, 1, out + num_decoded, block_offset);
+            continue;
+        }
+        for (uint32_t j = 0; j < 8; ++j) {
+            const uint32_t byte = static_cast<uint32_t>(block >> (j * 8)) & 0xFF;
+            const __m128i positions = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lut.positions[byte]));
+            store_byte_positions_avx2(out + num_decoded, positions, block_offset + static_cast<T>(j * 8));
+            num_decoded += popcount(static_cast<uint64_t>(byte));
+        }
+    }
+    return num_decoded;
+}
+
+template<typename T>
+_YAEF_ATTR_NODISCARD inline size_t 
+decode_bits_avx2(const uint64_t *blocks, size_t n, bool bit, T *out, size_t out_capacity, T index_offset) {
+    return bit ? decode_bits_avx2_impl<true>(blocks, n, out, out_capacity, index_offset) : 
+                 decode_bits_avx2_impl<false>(blocks, n, out, out_capacity, index_offset);
+}
+
+// fixed-size kernels always load NumWords words (8 or 16), the lanes 
+// beyond `num_blocks` are ignored.
+template<size_t NumWords>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+popcount_blocks_fixed_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_STATIC_ASSERT_NOMSG(NumWords % 4 == 0 && NumWords <= 16);
+    constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+
+    k = std::min(k, num_blocks * BLOCK_WIDTH);
+    const size_t last_block_index = k / BLOCK_WIDTH, 
+                 last_rem_bits = k % BLOCK_WIDTH;
+    
+    const __m256i last_index_vec = _mm256_set1_epi64x(static_cast<int64_t>(last_block_index));
+    __m256i lane_index_vec = _mm256_setr_epi64x(0, 1, 2, 3);
+    __m256i popcnts_vec = _mm256_setzero_si256();
+    for (size_t i = 0; i < NumWords; i += 4) {
+        // only the blocks before `last_block_index` are counted as a whole
+        const __m256i keep_mask = _mm256_cmpgt_epi64(last_index_vec, lane_index_vec);
+        const __m256i loaded_vec = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i)), keep_mask);
+        popcnts_vec = _mm256_add_epi64(popcnts_vec, popcount_epi64_avx2(loaded_vec));
+        lane_index_vec = _mm256_add_epi64(lane_index_vec, _mm256_set1_epi64x(4));
+    }
+
+    size_t res = reduce_add_epi64_avx2(popcnts_vec);
+    if (last_rem_bits != 0) {
+        res += popcount(extract_first_bits(blocks[last_block_index], last_rem_bits));
+    }
+    return res;
+}
+
+template<size_t NumWords, bool BitType>
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_blocks_fixed_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_STATIC_ASSERT_NOMSG(NumWords % 4 == 0 && NumWords <= 16);
+    constexpr size_t BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+    const __m256i FLIP_MASK = BitType ? _mm256_setzero_si256() : _mm256_set1_epi64x(-1);
+
+    if (_YAEF_UNLIKELY(k + 1 == 0)) {
+        return static_cast<size_t>(-1);
+    }
+
+    const __m256i index_vec = _mm256_set1_epi64x(
+        static_cast<int64_t>(std::min<size_t>(k, NumWords * BLOCK_WIDTH)));
+    __m256i prv_sum_vec = _mm256_setzero_si256();
+    uint64_t popcnts[NumWords];
+    uint32_t cmp_mask = 0;
+    for (size_t i = 0; i < NumWords; i += 4) {
+        const __m256i loaded_vec = _mm256_xor_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(blocks + i)), FLIP_MASK);
+        __m256i popcnts_vec = prefix_sum_epi64_avx2(popcount_epi64_avx2(loaded_vec));
+        popcnts_vec = _mm256_add_epi64(popcnts_vec, prv_sum_vec);
+        prv_sum_vec = _mm256_permute4x64_epi64(popcnts_vec, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(popcnts + i), popcnts_vec);
+        cmp_mask |= static_cast<uint32_t>(_mm256_movemask_pd(
+            _mm256_castsi256_pd(_mm256_cmpgt_epi64(popcnts_vec, index_vec)))) << i;
+    }
+    cmp_mask &= static_cast<uint32_t>(make_mask_lsb1(static_cast<uint32_t>(num_blocks)));
+    if (_YAEF_UNLIKELY(cmp_mask == 0)) {
+        return num_blocks * BLOCK_WIDTH;
+    }
+
+    const uint32_t lane_idx = count_trailing_zero(cmp_mask);
+    const uint64_t prv_num_ones = lane_idx == 0 ? 0 : popcnts[lane_idx - 1];
+    const uint64_t block = BitType ? blocks[lane_idx] : ~blocks[lane_idx];
+    return lane_idx * BLOCK_WIDTH + select_one(block, k - prv_num_ones);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+popcount_blocks_512_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return popcount_blocks_fixed_avx2<8>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_one_blocks_512_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_fixed_avx2<8, true>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_zero_blocks_512_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_fixed_avx2<8, false>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+popcount_blocks_1024_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return popcount_blocks_fixed_avx2<16>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_one_blocks_1024_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_fixed_avx2<16, true>(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD _YAEF_ATTR_TARGET_AVX2 inline size_t
+select_zero_blocks_1024_avx2(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return select_blocks_fixed_avx2<16, false>(blocks, num_blocks, k);
+}
+#endif
+
+// the 512/1024 entries may read the whole 8/16 words starting from `blocks`,
+// even if `num_blocks` is smaller.
+struct blocks_kernel_table {
+    using kernel_type        = size_t (*)(const uint64_t *, size_t, size_t);
+    using range_kernel_type  = size_t (*)(const uint64_t *, size_t);
+    using unpack_kernel_type = void (*)(const uint8_t *, uint32_t, size_t, uint64_t *);
+    using pack_kernel_type   = void (*)(const uint64_t *, uint32_t, size_t, uint8_t *);
+    using scan_kernel_type   = void (*)(const uint8_t *, uint32_t, size_t, uint64_t, uint64_t, uint8_t *);
+    using find_kernel_type   = size_t (*)(const uint8_t *, uint32_t, size_t, size_t, uint64_t);
+    using prefix_kernel_type = uint64_t (*)(const uint8_t *, uint32_t, size_t, uint64_t, uint64_t *);
+    using delta_kernel_type  = void (*)(uint64_t *, size_t, uint64_t);
+    using max_kernel_type    = uint64_t (*)(const uint8_t *, uint32_t, size_t);
+    using bitwise_kernel_type = size_t (*)(uint64_t *, const uint64_t *, const uint64_t *, size_t, bitwise_op, bool);
+    using find_block_kernel_type = size_t (*)(const uint64_t *, size_t, bool);
+    using decode_bits_u32_kernel_type = size_t (*)(const uint64_t *, size_t, bool, uint32_t *, size_t, uint32_t);
+    using decode_bits_u64_kernel_type = size_t (*)(const uint64_t *, size_t, bool, uint64_t *, size_t, uint64_t);
+
+    simd_tier          tier;
+    range_kernel_type  popcount_range;
+    unpack_kernel_type unpack_ints;
+    pack_kernel_type   pack_ints;
+    scan_kernel_type   scan_ints;
+    find_kernel_type   find_ints_not_less;
+    prefix_kernel_type unpack_prefix_sum_ints;
+    delta_kernel_type  delta_values;
+    max_kernel_type    max_ints;
+    bitwise_kernel_type bitwise_blocks;
+    find_block_kernel_type find_block_with_bit;
+    find_block_kernel_type rfind_block_with_bit;
+    decode_bits_u32_kernel_type decode_bits_u32;
+    decode_bits_u64_kernel_type decode_bits_u64;
+    kernel_type popcount_blocks;
+    kernel_type select_one_blocks;
+    kernel_type select_zero_blocks;
+    kernel_type popcount_blocks_512;
+    kernel_type select_one_blocks_512;
+    kernel_type select_zero_blocks_512;
+    kernel_type popcount_blocks_1024;
+    kernel_type select_one_blocks_1024;
+    kernel_type select_zero_blocks_1024;
+};
+
+_YAEF_ATTR_NODISCARD inline simd_tier detect_simd_tier() noexcept {
+    const cpu_features &features = get_cpu_features();
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX512
+    if (features.avx512f && features.avx512bw && features.avx512dq && 
+        features.avx512vl && features.avx512vpopcntdq && features.avx512vbmi) {
+        return simd_tier::avx512;
+    }
+#endif
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX2
+    if (features.avx2 && features.popcnt) {
+        return simd_tier::avx2;
+    }
+#endif
+    _YAEF_UNUSED(features);
+    return simd_tier::scalar;
+}
+
+_YAEF_ATTR_NODISCARD inline const blocks_kernel_table &get_blocks_kernel_table(simd_tier tier) noexcept {
+    static const blocks_kernel_table scalar_table = {
+        simd_tier::scalar,
+        &popcount_range_scalar, &unpack_ints_scalar, &pack_ints_scalar, &scan_ints_scalar,
+        &find_ints_not_less_scalar, &unpack_prefix_sum_ints_scalar, &delta_values_scalar, &max_ints_scalar,
+        &bitwise_blocks_scalar,
+        &find_block_with_bit_scalar,
+        &rfind_block_with_bit_scalar,
+        &decode_bits_scalar<uint32_t>,
+        &decode_bits_scalar<uint64_t>,
+        &popcount_blocks_scalar, &select_one_blocks_scalar, &select_zero_blocks_scalar,
+        &popcount_blocks_scalar, &select_one_blocks_scalar, &select_zero_blocks_scalar,
+        &popcount_blocks_scalar, &select_one_blocks_scalar, &select_zero_blocks_scalar
+    };
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX2
+    static const blocks_kernel_table avx2_table = {
+        simd_tier::avx2,
+        &popcount_range_avx2, &unpack_ints_avx2, &pack_ints_scalar, &scan_ints_avx2,
+        &find_ints_not_less_avx2, &unpack_prefix_sum_ints_avx2, &delta_values_avx2, &max_ints_avx2,
+        &bitwise_blocks_avx2,
+        &find_block_with_bit_avx2,
+        &rfind_block_with_bit_avx2,
+        &decode_bits_avx2<uint32_t>,
+        &decode_bits_avx2<uint64_t>,
+        &popcount_blocks_avx2, &select_one_blocks_avx2, &select_zero_blocks_avx2,
+        &popcount_blocks_512_avx2, &select_one_blocks_512_avx2, &select_zero_blocks_512_avx2,
+        &popcount_blocks_1024_avx2, &select_one_blocks_1024_avx2, &select_zero_blocks_1024_avx2
+    };
+    if (tier == simd_tier::avx2) {
+        return avx2_table;
+    }
+#endif
+#if _YAEF_INTRINSICS_CAN_EMIT_AVX512
+    static const blocks_kernel_table avx512_table = {
+        simd_tier::avx512,
+        &popcount_range_avx512, &unpack_ints_avx512, &pack_ints_avx512, &scan_ints_avx512,
+        &find_ints_not_less_avx512, &unpack_prefix_sum_ints_avx512, &delta_values_avx512, &max_ints_avx512,
+        &bitwise_blocks_avx512,
+        &find_block_with_bit_avx512,
+        &rfind_block_with_bit_avx512,
+        &decode_bits_avx512<uint32_t>,
+        &decode_bits_avx512<uint64_t>,
+        &popcount_blocks_avx2, &select_one_blocks_avx512, &select_zero_blocks_avx512,
+        &popcount_blocks_512_avx512<false>, &select_one_blocks_512_avx512<false>, 
+        &select_zero_blocks_512_avx512<false>,
+        &popcount_blocks_1024_avx512<false>, &select_one_blocks_1024_avx512<false>, 
+        &select_zero_blocks_1024_avx512<false>
+    };
+    if (tier == simd_tier::avx512) {
+        return avx512_table;
+    }
+#endif
+    _YAEF_UNUSED(tier);
+    return scalar_table;
+}
+
+// the tier may be overridden by env `YAEF_SIMD_TIER` (scalar, avx2, avx512), but never
+// beyond what the running cpu supports.
+_YAEF_ATTR_NODISCARD inline simd_tier initial_simd_tier() noexcept {
+    const simd_tier detected = detect_simd_tier();
+    const char *env = ::getenv("YAEF_SIMD_TIER");
+    if (env == nullptr) {
+        return detected;
+    }
+    simd_tier requested = detected;
+    if (::strcmp(env, "scalar") == 0) {
+        requested = simd_tier::scalar;
+    } else if (::strcmp(env, "avx2") == 0) {
+        requested = simd_tier::avx2;
+    } else if (::strcmp(env, "avx512") == 0) {
+        requested = simd_tier::avx512;
+    }
+    return std::min(requested, detected);
+}
+
+inline std::atomic<const blocks_kernel_table *> &active_blocks_kernel_table() noexcept {
+    static std::atomic<const blocks_kernel_table *> table{&get_blocks_kernel_table(initial_simd_tier())};
+    return table;
+}
+
+_YAEF_ATTR_NODISCARD inline const blocks_kernel_table &blocks_kernels() noexcept {
+    return *active_blocks_kernel_table().load(std::memory_order_relaxed);
+}
+
+// return count of 1s in the first n blocks
+_YAEF_ATTR_NODISCARD inline size_t
+popcount_range(const uint64_t *blocks, size_t n) {
+    return blocks_kernels().popcount_range(blocks, n);
+}
+
+// unpack `num_groups` groups of packed ints starting at `src`, see `PACKED_GROUP_SIZE`
+inline void unpack_ints(const uint8_t *src, uint32_t width, size_t num_groups, uint64_t *out) {
+    blocks_kernels().unpack_ints(src, width, num_groups, out);
+}
+
+// pack `num_groups` groups of ints from `src`, see `PACKED_GROUP_SIZE`
+inline void pack_ints(const uint64_t *src, uint32_t width, size_t num_groups, uint8_t *dst) {
+    blocks_kernels().pack_ints(src, width, num_groups, dst);
+}
+
+// test `num_groups` groups of packed ints against [min, min + range], one byte per group
+inline void scan_ints(const uint8_t *src, uint32_t width, size_t num_groups, 
+                      uint64_t min, uint64_t range, uint8_t *out) {
+    blocks_kernels().scan_ints(src, width, num_groups, min, range, out);
+}
+
+// find the first value not less than `target` in [first, last) of the packed ints at `src`, 
+// the groups overlapping the range are read as a whole
+_YAEF_ATTR_NODISCARD inline size_t 
+find_ints_not_less(const uint8_t *src, uint32_t width, size_t first, size_t last, uint64_t target) {
+    return blocks_kernels().find_ints_not_less(src, width, first, last, target);
+}
+
+// unpack `num_groups` groups of packed ints as their inclusive prefix sums starting from `init`,
+// return the last sum
+inline uint64_t unpack_prefix_sum_ints(const uint8_t *src, uint32_t width, size_t num_groups, 
+                                       uint64_t init, uint64_t *out) {
+    return blocks_kernels().unpack_prefix_sum_ints(src, width, num_groups, init, out);
+}
+
+// replace the values by their differences to the previous ones, see `delta_values_scalar`
+inline void delta_values(uint64_t *values, size_t n, uint64_t prev) {
+    blocks_kernels().delta_values(values, n, prev);
+}
+
+// return the max of `num_groups` groups of packed ints
+_YAEF_ATTR_NODISCARD inline uint64_t max_ints(const uint8_t *src, uint32_t width, size_t num_groups) {
+    return blocks_kernels().max_ints(src, width, num_groups);
+}
+
+// write `lhs op rhs` of n blocks to `dst` and optionally count its 1s, see `bitwise_blocks_scalar`
+inline size_t bitwise_blocks(uint64_t *dst, const uint64_t *lhs, const uint64_t *rhs, size_t n, 
+                             bitwise_op op, bool count) {
+    return blocks_kernels().bitwise_blocks(dst, lhs, rhs, n, op, count);
+}
+
+// return the index of the first of n blocks that contains a `bit`, or n if there is none
+_YAEF_ATTR_NODISCARD inline size_t find_block_with_bit(const uint64_t *blocks, size_t n, bool bit) {
+    return blocks_kernels().find_block_with_bit(blocks, n, bit);
+}
+
+// return the index of the last of n blocks that contains a `bit`, or n if there is none
+_YAEF_ATTR_NODISCARD inline size_t rfind_block_with_bit(const uint64_t *blocks, size_t n, bool bit) {
+    return blocks_kernels().rfind_block_with_bit(blocks, n, bit);
+}
+
+// write the indices of the 1s in n blocks, plus `index_offset`, to `out`, which has room for
+// `out_capacity` indices. the capacity must be at least their number, and passing the exact 
+// number lets the vector stores run up to the last index. returns their number.
+inline size_t decode_onebits(const uint64_t *blocks, size_t n, uint32_t *out, size_t out_capacity, 
+                             uint32_t index_offset = 0) {
+    return blocks_kernels().decode_bits_u32(blocks, n, true, out, out_capacity, index_offset);
+}
+
+inline size_t decode_onebits(const uint64_t *blocks, size_t n, uint64_t *out, size_t out_capacity, 
+                             uint64_t index_offset = 0) {
+    return blocks_kernels().decode_bits_u64(blocks, n, true, out, out_capacity, index_offset);
+}
+
+// same as `decode_onebits` but for the 0s, including the padding bits of the last block
+inline size_t decode_zerobits(const uint64_t *blocks, size_t n, uint32_t *out, size_t out_capacity, 
+                              uint32_t index_offset = 0) {
+    return blocks_kernels().decode_bits_u32(blocks, n, false, out, out_capacity, index_offset);
+}
+
+inline size_t decode_zerobits(const uint64_t *blocks, size_t n, uint64_t *out, size_t out_capacity, 
+                              uint64_t index_offset = 0) {
+    return blocks_kernels().decode_bits_u64(blocks, n, false, out, out_capacity, index_offset);
+}
+
+// fold `num_srcs` arrays of n blocks with `op` into `dst`, which may be one of the sources. 
+// the blocks are folded a tile at a time, so the partial results stay in the L1 cache 
+// instead of going through memory once per operand.
+inline size_t bitwise_reduce_blocks(uint64_t *dst, const uint64_t *const *srcs, size_t num_srcs, size_t n, 
+                                    bitwise_op op, bool count) {
+    _YAEF_ASSERT(num_srcs != 0);
+    constexpr size_t TILE_NUM_BLOCKS = 512;
+    size_t num_ones = 0;
+    for (size_t first = 0; first < n; first += TILE_NUM_BLOCKS) {
+        const size_t num = std::min(TILE_NUM_BLOCKS, n - first);
+        if (num_srcs == 1) {
+            num_ones += bitwise_blocks(dst + first, srcs[0] + first, srcs[0] + first, num, bitwise_op::bit_or, count);
+            continue;
+        }
+        // only the last pass writes to `dst`, so it is fine for `dst` to be one of the sources
+        uint64_t tile[TILE_NUM_BLOCKS];
+        const uint64_t *acc = srcs[0] + first;
+        for (size_t k = 1; k < num_srcs; ++k) {
+            const bool is_last = k + 1 == num_srcs;
+            uint64_t *out = is_last ? dst + first : tile;
+            num_ones += bitwise_blocks(out, acc, srcs[k] + first, num, op, count && is_last);
+            acc = tile;
+        }
+    }
+    return num_ones;
+}
+
+// return count of 1s in preceding k bits
+_YAEF_ATTR_NODISCARD inline size_t
+popcount_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return blocks_kernels().popcount_blocks(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_one_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return blocks_kernels().select_one_blocks(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_zero_blocks(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    return blocks_kernels().select_zero_blocks(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+popcount_blocks_512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 8);
+    return blocks_kernels().popcount_blocks_512(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_one_blocks_512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 8);
+    return blocks_kernels().select_one_blocks_512(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_zero_blocks_512(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 8);
+    return blocks_kernels().select_zero_blocks_512(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+popcount_blocks_1024(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 16);
+    return blocks_kernels().popcount_blocks_1024(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_one_blocks_1024(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 16);
+    return blocks_kernels().select_one_blocks_1024(blocks, num_blocks, k);
+}
+
+_YAEF_ATTR_NODISCARD inline size_t
+select_zero_blocks_1024(const uint64_t *blocks, size_t num_blocks, size_t k) {
+    _YAEF_ASSERT(num_blocks <= 16);
+    return blocks_kernels().select_zero_blocks_1024(blocks, num_blocks, k);
+}
+
+class bit_view;
+class packed_int_view;
+
+class packed_int_view {
+public:
+    using value_type = uint64_t;
+    using block_type = uint64_t;
+    using size_type  = size_t;
+    static constexpr uint32_t BLOCK_WIDTH = sizeof(block_type) * CHAR_BIT;
+
+public:
+    packed_int_view() noexcept
+        : blocks_(nullptr), num_elems_(0), width_(0) { }
+
+    packed_int_view(const packed_int_view &) = default;
+
+    packed_int_view(uint32_t width, block_type *blocks, size_type num_elems) noexcept
+        : blocks_(blocks), num_elems_(num_elems), width_(width) { }
+
+    packed_int_view &operator=(const packed_int_view &) = default;
+
+    _YAEF_ATTR_NODISCARD size_type size() const noexcept { return num_elems_; }
+    _YAEF_ATTR_NODISCARD bool empty() const noexcept { return size() == 0; }
+    _YAEF_ATTR_NODISCARD uint32_t width() const noexcept { return width_; }
+    _YAEF_ATTR_NODISCARD const block_type *blocks() const noexcept { return blocks_; }
+    _YAEF_ATTR_NODISCARD block_type *blocks() noexcept { return blocks_; }
+
+    _YAEF_ATTR_NODISCARD size_type num_blocks() const noexcept { 
+        return bits64::idiv_ceil(num_elems_ * width_, BLOCK_WIDTH); 
+    }
+
+    _YAEF_ATTR_NODISCARD value_type limit_min() const { return 0; }
+    
+    _YAEF_ATTR_NODISCARD value_type limit_max() const {
+        if (_YAEF_UNLIKELY(width() == sizeof(value_type) * CHAR_BIT)) { 
+            return std::numeric_limits<value_type>::max(); 
+        }
+        return (static_cast<value_type>(1) << width()) - 1;
+    }
+
+    _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
+        return sizeof(block_type) * num_blocks();
+    }
+
+    void fill(value_type value) {
+        if (_YAEF_UNLIKELY(value == limit_min())) {
+            clear_all_bits();
+            return;
+        }
+        if (_YAEF_UNLIKELY(value == limit_max())) {
+            set_all_bits();
+            return;
+        }
+        for (size_type i = 0; i < size(); ++i) {
+            set_value(i, value);
+        }
+    }
+
+    void prefetch_for_read(size_type first, size_type last) const noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+
+        const size_type first_block_index = first * width() / BLOCK_WIDTH;
+        const size_type last_block_index = last * width() / BLOCK_WIDTH;
+        const size_type num_blocks = last_block_index - first_block_index + 1;
+        constexpr size_type STEP = 64 / sizeof(block_type);
+        for (size_type i = 0; i < num_blocks; i += STEP) {
+            prefetch_read(blocks() + first_block_index + i);
+        }
+    }
+
+    void prefetch_for_write(size_type first, size_type last) noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+
+        const size_type first_block_index = first * width() / BLOCK_WIDTH;
+        const size_type last_block_index = last * width() / BLOCK_WIDTH;
+        const size_type num_blocks = last_block_index - first_block_index + 1;
+        constexpr size_type STEP = 64 / sizeof(block_type);
+        for (size_type i = 0; i < num_blocks; i += STEP) {
+            prefetch_write(blocks() + first_block_index + i);
+        }
+    }
+
+    _YAEF_ATTR_NODISCARD bit_view to_bit_view() noexcept;
 
     _YAEF_ATTR_NODISCARD value_type get_value(size_type index) const noexcept {
         _YAEF_ASSERT(index < size());
@@ -1549,7 +3442,201 @@ public:
         } else {
             return extract_bits(blocks_[block_index], block_offset, block_offset + width());
         }
-#endif
+#endif
+    }
+
+    // unpack the values in [first, last) into `out`. the aligned groups in the middle are 
+    // handed to the unpack kernels, as long as their reads stay inside the blocks.
+    void get_values(size_type first, size_type last, value_type *out) const noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (_YAEF_UNLIKELY(width() == 0)) {
+            std::fill(out, out + (last - first), 0);
+            return;
+        }
+
+        if (width() <= PACKED_GROUP_MAX_WIDTH) {
+            for (; first < last && first % PACKED_GROUP_SIZE != 0; ++first) {
+                *out++ = get_value(first);
+            }
+            const size_type first_byte = first / PACKED_GROUP_SIZE * width();
+            const size_type num_bytes = num_blocks() * sizeof(block_type);
+            size_type num_groups = (last - first) / PACKED_GROUP_SIZE;
+            if (first_byte + UNPACK_GROUP_READ_BYTES <= num_bytes) {
+                num_groups = std::min(num_groups, (num_bytes - first_byte - UNPACK_GROUP_READ_BYTES) / width() + 1);
+            } else {
+                num_groups = 0;
+            }
+            unpack_ints(reinterpret_cast<const uint8_t *>(blocks_) + first_byte, width(), num_groups, out);
+            first += num_groups * PACKED_GROUP_SIZE;
+            out += num_groups * PACKED_GROUP_SIZE;
+        }
+        for (; first < last; ++first) {
+            *out++ = get_value(first);
+        }
+    }
+
+    // return the index of the first value in [first, last) that is not less than `target`,
+    // or `last` if there is none. the values need not be sorted.
+    _YAEF_ATTR_NODISCARD size_type find_not_less(size_type first, size_type last, value_type target) const noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (_YAEF_UNLIKELY(width() == 0)) {
+            return target == 0 ? first : last;
+        }
+
+        if (width() <= PACKED_GROUP_MAX_WIDTH) {
+            // only the groups whose reads stay inside the blocks go to the find kernels
+            const size_type num_bytes = num_blocks() * sizeof(block_type);
+            const size_type num_readable_groups = num_bytes >= UNPACK_GROUP_READ_BYTES ? 
+                (num_bytes - UNPACK_GROUP_READ_BYTES) / width() + 1 : 0;
+            const size_type kernel_last = std::min(last, num_readable_groups * PACKED_GROUP_SIZE);
+            if (first < kernel_last) {
+                const size_type res = find_ints_not_less(reinterpret_cast<const uint8_t *>(blocks_), 
+                                                         width(), first, kernel_last, target);
+                if (res != kernel_last) {
+                    return res;
+                }
+                first = kernel_last;
+            }
+        }
+        for (; first < last; ++first) {
+            if (get_value(first) >= target) { return first; }
+        }
+        return last;
+    }
+
+    // write the inclusive prefix sums of the values in [first, last), starting from `init`, to 
+    // `out` and return the last sum. the aligned groups are unpacked and summed in registers.
+    value_type get_prefix_sums(size_type first, size_type last, value_type *out, value_type init = 0) const noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (_YAEF_UNLIKELY(width() == 0)) {
+            std::fill(out, out + (last - first), init);
+            return init;
+        }
+
+        if (width() <= PACKED_GROUP_MAX_WIDTH) {
+            for (; first < last && first % PACKED_GROUP_SIZE != 0; ++first) {
+                init += get_value(first);
+                *out++ = init;
+            }
+            const size_type first_byte = first / PACKED_GROUP_SIZE * width();
+            const size_type num_bytes = num_blocks() * sizeof(block_type);
+            size_type num_groups = (last - first) / PACKED_GROUP_SIZE;
+            if (first_byte + UNPACK_GROUP_READ_BYTES <= num_bytes) {
+                num_groups = std::min(num_groups, (num_bytes - first_byte - UNPACK_GROUP_READ_BYTES) / width() + 1);
+            } else {
+                num_groups = 0;
+            }
+            if (num_groups != 0) {
+                init = unpack_prefix_sum_ints(reinterpret_cast<const uint8_t *>(blocks_) + first_byte, 
+                                              width(), num_groups, init, out);
+                first += num_groups * PACKED_GROUP_SIZE;
+                out += num_groups * PACKED_GROUP_SIZE;
+            }
+        }
+        for (; first < last; ++first) {
+            init += get_value(first);
+            *out++ = init;
+        }
+        return init;
+    }
+
+    // return the max of the values in [first, last), or 0 if the range is empty
+    _YAEF_ATTR_NODISCARD value_type find_max_value(size_type first, size_type last) const noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (_YAEF_UNLIKELY(width() == 0)) {
+            return 0;
+        }
+
+        value_type res = 0;
+        if (width() <= PACKED_GROUP_MAX_WIDTH) {
+            for (; first < last && first % PACKED_GROUP_SIZE != 0; ++first) {
+                res = std::max(res, get_value(first));
+            }
+            const size_type first_byte = first / PACKED_GROUP_SIZE * width();
+            const size_type num_bytes = num_blocks() * sizeof(block_type);
+            size_type num_groups = (last - first) / PACKED_GROUP_SIZE;
+            if (first_byte + UNPACK_GROUP_READ_BYTES <= num_bytes) {
+                num_groups = std::min(num_groups, (num_bytes - first_byte - UNPACK_GROUP_READ_BYTES) / width() + 1);
+            } else {
+                num_groups = 0;
+            }
+            if (num_groups != 0) {
+                res = std::max(res, max_ints(reinterpret_cast<const uint8_t *>(blocks_) + first_byte, 
+                                             width(), num_groups));
+                first += num_groups * PACKED_GROUP_SIZE;
+            }
+        }
+        for (; first < last; ++first) {
+            res = std::max(res, get_value(first));
+        }
+        return res;
+    }
+
+    // replace the values in [first, last) by their differences to the previous ones, the first 
+    // value is kept. the differences are truncated to `width` bits, so `delta_decode` restores 
+    // the values even if they are not sorted.
+    void delta_encode(size_type first, size_type last) noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        constexpr size_type STAGE_SIZE = 256;
+        value_type staged[STAGE_SIZE];
+        value_type prev = 0;
+        for (size_type i = first; i < last; i += STAGE_SIZE) {
+            const size_type num = std::min(STAGE_SIZE, last - i);
+            get_values(i, i + num, staged);
+            const value_type next_prev = staged[num - 1];
+            delta_values(staged, num, prev);
+            set_values(i, i + num, staged);
+            prev = next_prev;
+        }
+    }
+
+    // the inverse of `delta_encode`, replace the values in [first, last) by their prefix sums
+    void delta_decode(size_type first, size_type last) noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        constexpr size_type STAGE_SIZE = 256;
+        value_type staged[STAGE_SIZE];
+        value_type sum = 0;
+        for (size_type i = first; i < last; i += STAGE_SIZE) {
+            const size_type num = std::min(STAGE_SIZE, last - i);
+            sum = get_prefix_sums(i, i + num, staged, sum);
+            set_values(i, i + num, staged);
+        }
+    }
+
+    // test the values in [first, last) against [min, max] and write the result of the i-th value
+    // to the bit `i - first` of `out`. the aligned groups are tested by the scan kernels straight
+    // from the packed blocks, without unpacking them to memory.
+    void scan_between(size_type first, size_type last, value_type min, value_type max, bit_view out) const;
+
+    // pack the values of `src` into [first, last), the values are truncated to `width` bits.
+    // the aligned groups in the middle are written by the pack kernels without touching 
+    // the bits out of the range.
+    void set_values(size_type first, size_type last, const value_type *src) noexcept {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (_YAEF_UNLIKELY(width() == 0)) {
+            return;
+        }
+
+        if (width() <= PACKED_GROUP_MAX_WIDTH) {
+            for (; first < last && first % PACKED_GROUP_SIZE != 0; ++first) {
+                set_value(first, *src++);
+            }
+            const size_type first_byte = first / PACKED_GROUP_SIZE * width();
+            const size_type num_groups = (last - first) / PACKED_GROUP_SIZE;
+            pack_ints(src, width(), num_groups, reinterpret_cast<uint8_t *>(blocks_) + first_byte);
+            first += num_groups * PACKED_GROUP_SIZE;
+            src += num_groups * PACKED_GROUP_SIZE;
+        }
+        for (; first < last; ++first) {
+            set_value(first, *src++);
+        }
     }
 
     void set_value(size_type index, value_type value) noexcept {
@@ -1569,6 +3656,66 @@ public:
         }
     }
 
+    // same as `get_value`, but all the shifts and masks are folded for a width known at 
+    // compile time. `W` must be equal to `width()`.
+    template<uint32_t W>
+    _YAEF_ATTR_NODISCARD value_type get_value(size_type index, assumed_width_t<W>) const noexcept {
+        _YAEF_STATIC_ASSERT_NOMSG(W > 0 && W <= BLOCK_WIDTH);
+        _YAEF_ASSERT(W == width());
+        _YAEF_ASSERT(index < size());
+        constexpr value_type MASK = W == BLOCK_WIDTH ? ~value_type{0} : (value_type{1} << (W % BLOCK_WIDTH)) - 1;
+        constexpr size_type NUM_PER_BLOCK = BLOCK_WIDTH / W;
+
+        if _YAEF_CXX17_CONSTEXPR (BLOCK_WIDTH % W == 0) {
+            // values never cross the block boundaries
+            return (blocks_[index / NUM_PER_BLOCK] >> (index % NUM_PER_BLOCK * W)) & MASK;
+        }
+
+        const size_type bit_index = index * W;
+        const size_type block_index = bit_index / BLOCK_WIDTH, 
+                        block_offset = bit_index % BLOCK_WIDTH;
+#if _YAEF_INTRINSICS_HAVE_AVX2 && defined(__SIZEOF_INT128__) && __SIZEOF_INT128__ == 16
+        __uint128_t combined;
+        memcpy(&combined, blocks_ + block_index, sizeof(combined));
+        return static_cast<value_type>(combined >> block_offset) & MASK;
+#else
+        value_type result = blocks_[block_index] >> block_offset;
+        if (block_offset + W > BLOCK_WIDTH) {
+            result |= blocks_[block_index + 1] << (BLOCK_WIDTH - block_offset);
+        }
+        return result & MASK;
+#endif
+    }
+
+    // same as `set_value` with a width known at compile time. `W` must be equal to `width()`.
+    template<uint32_t W>
+    void set_value(size_type index, value_type value, assumed_width_t<W>) noexcept {
+        _YAEF_STATIC_ASSERT_NOMSG(W > 0 && W <= BLOCK_WIDTH);
+        _YAEF_ASSERT(W == width());
+        _YAEF_ASSERT(index < size());
+        constexpr value_type MASK = W == BLOCK_WIDTH ? ~value_type{0} : (value_type{1} << (W % BLOCK_WIDTH)) - 1;
+        constexpr size_type NUM_PER_BLOCK = BLOCK_WIDTH / W;
+        value &= MASK;
+
+        if _YAEF_CXX17_CONSTEXPR (BLOCK_WIDTH % W == 0) {
+            block_type &block = blocks_[index / NUM_PER_BLOCK];
+            const uint32_t block_offset = index % NUM_PER_BLOCK * W;
+            block = (block & ~(MASK << block_offset)) | (value << block_offset);
+            return;
+        }
+
+        const size_type bit_index = index * W;
+        const size_type block_index = bit_index / BLOCK_WIDTH, 
+                        block_offset = bit_index % BLOCK_WIDTH;
+        block_type &block0 = blocks_[block_index];
+        block0 = (block0 & ~(MASK << block_offset)) | (value << block_offset);
+        if (block_offset + W > BLOCK_WIDTH) {
+            const uint32_t num_low_bits = BLOCK_WIDTH - block_offset;
+            block_type &block1 = blocks_[block_index + 1];
+            block1 = (block1 & ~(MASK >> num_low_bits)) | (value >> num_low_bits);
+        }
+    }
+
     _YAEF_ATTR_NODISCARD bool get_bit(size_type index) const noexcept {
         _YAEF_ASSERT(index < size() * width());
         auto info = locate_block(index);
@@ -1821,6 +3968,46 @@ public:
         do_modify_bits<false>(offset, len);
     }
 
+    // return the index of the first 1 at or after `pos`, or size() if there is none
+    _YAEF_ATTR_NODISCARD size_type find_next_one(size_type pos) const { return find_next_bit<true>(pos); }
+    // return the index of the first 0 at or after `pos`, or size() if there is none
+    _YAEF_ATTR_NODISCARD size_type find_next_zero(size_type pos) const { return find_next_bit<false>(pos); }
+    // return the index of the last 1 at or before `pos`, or size() if there is none
+    _YAEF_ATTR_NODISCARD size_type find_prev_one(size_type pos) const { return find_prev_bit<true>(pos); }
+    // return the index of the last 0 at or before `pos`, or size() if there is none
+    _YAEF_ATTR_NODISCARD size_type find_prev_zero(size_type pos) const { return find_prev_bit<false>(pos); }
+
+    // this = this op rhs, returns the number of 1s of the result if `count_ones`, otherwise 0
+    size_type combine_with(bitwise_op op, const bit_view &rhs, bool count_ones = false) {
+        return assign_combined(op, *this, rhs, count_ones);
+    }
+
+    // this = lhs op rhs, all of the same size. either operand may be this view itself.
+    size_type assign_combined(bitwise_op op, const bit_view &lhs, const bit_view &rhs, bool count_ones = false) {
+        _YAEF_ASSERT(lhs.size() == size() && rhs.size() == size());
+        const size_type num_ones = bitwise_blocks(blocks_, lhs.blocks_, rhs.blocks_, num_blocks(), op, count_ones);
+        return num_ones - clear_padding_bits(count_ones);
+    }
+
+    // this = srcs[0] op srcs[1] op ... op srcs[num_srcs - 1], folded from the left in a single pass
+    size_type assign_combined(bitwise_op op, const bit_view *const *srcs, size_type num_srcs, bool count_ones = false) {
+        _YAEF_ASSERT(num_srcs != 0);
+        constexpr size_type MAX_STACK_SRCS = 16;
+        const block_type *stack_srcs[MAX_STACK_SRCS];
+        std::vector<const block_type *> heap_srcs;
+        const block_type **src_blocks = stack_srcs;
+        if (num_srcs > MAX_STACK_SRCS) {
+            heap_srcs.resize(num_srcs);
+            src_blocks = heap_srcs.data();
+        }
+        for (size_type i = 0; i < num_srcs; ++i) {
+            _YAEF_ASSERT(srcs[i]->size() == size());
+            src_blocks[i] = srcs[i]->blocks_;
+        }
+        const size_type num_ones = bitwise_reduce_blocks(blocks_, src_blocks, num_srcs, num_blocks(), op, count_ones);
+        return num_ones - clear_padding_bits(count_ones);
+    }
+
     _YAEF_ATTR_NODISCARD uint64_t get_bits(size_type index, uint32_t w) const {
         _YAEF_ASSERT(index < size());
         _YAEF_ASSERT(index + w <= size());
@@ -1870,6 +4057,10 @@ public:
     template<typename AllocT>
     error_code deserialize(AllocT &alloc, deserializer &deser);
 
+    // `deserialize` with the number of bits already read
+    template<typename AllocT>
+    error_code deserialize_blocks(AllocT &alloc, deserializer &deser, size_type num_bits);
+
 private:
     block_type *blocks_;
     size_type   num_bits_;
@@ -1884,6 +4075,46 @@ private:
         return std::make_pair(blocks_ + block_index, static_cast<uint32_t>(block_offset));
     }
 
+    template<bool Bit>
+    _YAEF_ATTR_NODISCARD size_type find_next_bit(size_type pos) const {
+        if (_YAEF_UNLIKELY(pos >= size())) { return size(); }
+        size_type block_idx = pos / BLOCK_WIDTH;
+        block_type block = (Bit ? blocks_[block_idx] : ~blocks_[block_idx]) & ~make_mask_lsb1(pos % BLOCK_WIDTH);
+        if (block == 0) {
+            // the padding bits are 0s, so a 0 found there is clamped to size()
+            const size_type num_rem_blocks = num_blocks() - block_idx - 1;
+            const size_type offset = find_block_with_bit(blocks_ + block_idx + 1, num_rem_blocks, Bit);
+            if (offset == num_rem_blocks) { return size(); }
+            block_idx += offset + 1;
+            block = Bit ? blocks_[block_idx] : ~blocks_[block_idx];
+        }
+        return std::min(size(), block_idx * BLOCK_WIDTH + count_trailing_zero(block));
+    }
+
+    template<bool Bit>
+    _YAEF_ATTR_NODISCARD size_type find_prev_bit(size_type pos) const {
+        _YAEF_ASSERT(pos < size());
+        size_type block_idx = pos / BLOCK_WIDTH;
+        block_type block = (Bit ? blocks_[block_idx] : ~blocks_[block_idx]) & make_mask_lsb1(pos % BLOCK_WIDTH + 1);
+        if (block == 0) {
+            const size_type offset = rfind_block_with_bit(blocks_, block_idx, Bit);
+            if (offset == block_idx) { return size(); }
+            block_idx = offset;
+            block = Bit ? blocks_[block_idx] : ~blocks_[block_idx];
+        }
+        return block_idx * BLOCK_WIDTH + (BLOCK_WIDTH - 1 - count_leading_zero(block));
+    }
+
+    // clear the bits past the end in the last block, returns how many of them were set if `count`
+    size_type clear_padding_bits(bool count) noexcept {
+        const uint32_t num_tail_bits = size() % BLOCK_WIDTH;
+        if (num_tail_bits == 0) { return 0; }
+        block_type &last_block = blocks_[num_blocks() - 1];
+        const block_type padding = last_block & ~make_mask_lsb1(num_tail_bits);
+        last_block ^= padding;
+        return count ? popcount(padding) : 0;
+    }
+
     template<bool Op>
     void do_modify_bits(size_t pos, size_t len) {
         if (_YAEF_UNLIKELY(len == 0)) {
@@ -1956,6 +4187,64 @@ inline bit_view packed_int_view::to_bit_view() noexcept {
     return bit_view(blocks_, num_elems_ * width_);
 }
 
+inline void packed_int_view::scan_between(size_type first, size_type last, 
+                                          value_type min, value_type max, bit_view out) const {
+    _YAEF_ASSERT(first <= last);
+    _YAEF_ASSERT(last <= size());
+    _YAEF_ASSERT(last - first <= out.size());
+    if (_YAEF_UNLIKELY(first == last)) {
+        return;
+    }
+    if (_YAEF_UNLIKELY(min > max)) {
+        out.clear_all_bits(0, last - first);
+        return;
+    }
+    const value_type range = max - min;
+    if (_YAEF_UNLIKELY(width() == 0)) {
+        if (min == 0) {
+            out.set_all_bits(0, last - first);
+        } else {
+            out.clear_all_bits(0, last - first);
+        }
+        return;
+    }
+
+    size_type out_index = 0;
+    if (width() <= PACKED_GROUP_MAX_WIDTH) {
+        for (; first < last && first % PACKED_GROUP_SIZE != 0; ++first) {
+            out.set_bit(out_index++, get_value(first) - min <= range);
+        }
+        const size_type first_byte = first / PACKED_GROUP_SIZE * width();
+        const size_type num_bytes = num_blocks() * sizeof(block_type);
+        size_type num_groups = (last - first) / PACKED_GROUP_SIZE;
+        if (first_byte + UNPACK_GROUP_READ_BYTES <= num_bytes) {
+            num_groups = std::min(num_groups, (num_bytes - first_byte - UNPACK_GROUP_READ_BYTES) / width() + 1);
+        } else {
+            num_groups = 0;
+        }
+
+        // the matches of 8 groups fill a whole word
+        constexpr size_type CHUNK_NUM_GROUPS = 64;
+        uint64_t matches[CHUNK_NUM_GROUPS / 8] = {};
+        const uint8_t *src = reinterpret_cast<const uint8_t *>(blocks_) + first_byte;
+        while (num_groups != 0) {
+            const size_type chunk_num_groups = std::min(CHUNK_NUM_GROUPS, num_groups);
+            scan_ints(src, width(), chunk_num_groups, min, range, reinterpret_cast<uint8_t *>(matches));
+            for (size_type k = 0; k < chunk_num_groups; k += 8) {
+                const uint32_t num_bits = static_cast<uint32_t>(std::min<size_type>(8, chunk_num_groups - k) * 8);
+                out.set_bits(out_index, num_bits, matches[k / 8]);
+                out_index += num_bits;
+            }
+            src += chunk_num_groups * width();
+            first += chunk_num_groups * PACKED_GROUP_SIZE;
+            num_groups -= chunk_num_groups;
+        }
+    }
+    for (; first < last; ++first) {
+        out.set_bit(out_index++, get_value(first) - min <= range);
+    }
+}
+
 inline packed_int_view bit_view::to_packed_int_view(uint32_t w) _YAEF_MAYBE_NOEXCEPT {
     if (_YAEF_UNLIKELY(num_bits_ % w != 0)) {
         _YAEF_THROW(std::invalid_argument("the number of bits must be a multiple of `w`"));
@@ -1963,13 +4252,59 @@ inline packed_int_view bit_view::to_packed_int_view(uint32_t w) _YAEF_MAYBE_NOEX
     return packed_int_view(w, blocks_, num_bits_ / w);
 }
 
+// iterate over the runs of 1s, yielding the start and the length of each run
+class bitmap_run_cursor {
+public:
+    using size_type = size_t;
+
+public:
+    bitmap_run_cursor() noexcept
+        : bits_(), start_(0), end_(0) { }
+
+    explicit bitmap_run_cursor(const bit_view &bits)
+        : bits_(bits), start_(0), end_(0) {
+        seek(0);
+    }
+
+    // start from the first 1 at or after `pos`, a run covering `pos` is cut to start at `pos`
+    bitmap_run_cursor(const bit_view &bits, size_type pos)
+        : bits_(bits), start_(0), end_(0) {
+        seek(pos);
+    }
+
+    _YAEF_ATTR_NODISCARD bool is_valid() const noexcept { return start_ < bits_.size(); }
+    _YAEF_ATTR_NODISCARD size_type start() const noexcept { return start_; }
+    _YAEF_ATTR_NODISCARD size_type length() const noexcept { return end_ - start_; }
+
+    _YAEF_ATTR_NODISCARD std::pair<size_type, size_type> current() const noexcept {
+        return std::make_pair(start(), length());
+    }
+
+    void next() {
+        _YAEF_ASSERT(is_valid());
+        seek(end_);
+    }
+
+private:
+    bit_view  bits_;
+    size_type start_;
+    size_type end_;
+
+    void seek(size_type pos) {
+        start_ = bits_.find_next_one(pos);
+        end_ = start_ < bits_.size() ? bits_.find_next_zero(start_) : start_;
+    }
+};
+
 class bits_stat_info;
-bits_stat_info stats_bits(const bit_view &) noexcept;
+bits_stat_info stats_bits(const bit_view &, bool) noexcept;
 
 class bits_stat_info {
-    friend bits_stat_info stats_bits(const bit_view &) noexcept;
+    friend bits_stat_info stats_bits(const bit_view &, bool) noexcept;
 public:
     using size_type = size_t;
+    // bucket i counts the runs whose length has a bit width of i
+    using run_histogram = std::array<size_type, 65>;
 
     _YAEF_ATTR_NODISCARD size_type size() const noexcept { return size_; }
     _YAEF_ATTR_NODISCARD size_type num_ones() const noexcept { return num_ones_; }
@@ -1983,12 +4318,30 @@ public:
         return static_cast<double>(num_zeros()) / static_cast<double>(size());
     }
 
+    // the statistics below are only available if the runs were requested from `stats_bits`
+    _YAEF_ATTR_NODISCARD bool has_run_stats() const noexcept { return has_run_stats_; }
+    _YAEF_ATTR_NODISCARD size_type num_one_runs() const noexcept { return num_one_runs_; }
+    _YAEF_ATTR_NODISCARD size_type num_zero_runs() const noexcept { return num_zero_runs_; }
+    _YAEF_ATTR_NODISCARD size_type longest_one_run() const noexcept { return longest_one_run_; }
+    _YAEF_ATTR_NODISCARD size_type longest_zero_run() const noexcept { return longest_zero_run_; }
+    // the widths of the gaps, i.e. the runs of 0s, including those at both ends
+    _YAEF_ATTR_NODISCARD const run_histogram &gap_width_histogram() const noexcept { return gap_width_histogram_; }
+
 private:
-    size_type size_;
-    size_type num_ones_;
+    size_type     size_ = 0;
+    size_type     num_ones_ = 0;
+    bool          has_run_stats_ = false;
+    size_type     num_one_runs_ = 0;
+    size_type     num_zero_runs_ = 0;
+    size_type     longest_one_run_ = 0;
+    size_type     longest_zero_run_ = 0;
+    run_histogram gap_width_histogram_ = {};
 };
 
-_YAEF_ATTR_NODISCARD inline bits_stat_info stats_bits(const bit_view &bits) noexcept {
+// count the 1s, and if `stat_runs` also the runs and their lengths, in one pass over the blocks. 
+// the run that reaches the end of the blocks seen so far is carried to the next block. the blocks 
+// inside it are skipped by `find_block_with_bit`, the others close a run at each run start/end.
+_YAEF_ATTR_NODISCARD inline bits_stat_info stats_bits(const bit_view &bits, bool stat_runs = false) noexcept {
     using size_type = bit_view::size_type;
     constexpr size_type BLOCK_WIDTH = bit_view::BLOCK_WIDTH;
 
@@ -1998,13 +4351,64 @@ _YAEF_ATTR_NODISCARD inline bits_stat_info stats_bits(const bit_view &bits) noex
                     num_residual_bits = num_bits % BLOCK_WIDTH;
     bits_stat_info info;
     info.size_ = num_bits;
-    info.num_ones_ = 0;
-    for (size_type i = 0; i < num_full_blocks; ++i) {
-        info.num_ones_ += popcount(blocks[i]);
-    }
-    if (num_residual_bits != 0) {
-        info.num_ones_ += popcount(extract_first_bits(blocks[num_full_blocks], num_residual_bits));
+    info.has_run_stats_ = stat_runs;
+    if (!stat_runs || num_bits == 0) {
+        info.num_ones_ = popcount_range(blocks, num_full_blocks);
+        if (num_residual_bits != 0) {
+            info.num_ones_ += popcount(extract_first_bits(blocks[num_full_blocks], num_residual_bits));
+        }
+        return info;
+    }
+
+    bool open_bit = bits.get_bit(0);
+    size_type open_len = 0;
+    auto close_run = [&info, &open_bit](size_type len) {
+        if (open_bit) {
+            ++info.num_one_runs_;
+            info.num_ones_ += len;
+            info.longest_one_run_ = std::max(info.longest_one_run_, len);
+        } else {
+            ++info.num_zero_runs_;
+            info.longest_zero_run_ = std::max(info.longest_zero_run_, len);
+            ++info.gap_width_histogram_[bit_width(len)];
+        }
+        open_bit = !open_bit;
+    };
+
+    const size_type num_blocks = idiv_ceil(num_bits, BLOCK_WIDTH);
+    // the first bit continues the open run
+    uint64_t prev_block = open_bit ? UINT64_MAX : 0;
+    for (size_type i = 0; i < num_blocks; ++i) {
+        const uint64_t block = blocks[i];
+        uint64_t bounds = run_starts(block, prev_block) | run_ends(block, prev_block);
+        size_type block_width = BLOCK_WIDTH;
+        if (i == num_full_blocks) {
+            bounds = extract_first_bits(bounds, static_cast<uint32_t>(num_residual_bits));
+            block_width = num_residual_bits;
+        }
+
+        if (bounds == 0) {
+            // the full blocks up to the next one with the other bit are in the open run
+            const size_type num_skipped = i + 1 < num_full_blocks ? 
+                find_block_with_bit(blocks + i + 1, num_full_blocks - i - 1, !open_bit) : 0;
+            open_len += block_width + num_skipped * BLOCK_WIDTH;
+            i += num_skipped;
+            prev_block = open_bit ? UINT64_MAX : 0;
+            continue;
+        }
+
+        size_type pos = 0;
+        while (bounds != 0) {
+            const size_type bound_pos = count_trailing_zero(bounds);
+            close_run(open_len + bound_pos - pos);
+            open_len = 0;
+            pos = bound_pos;
+            bounds &= bounds - 1;
+        }
+        open_len = block_width - pos;
+        prev_block = block;
     }
+    close_run(open_len);
     return info;
 }
 
@@ -2061,6 +4465,58 @@ inline size_t bitmap_foreach_zerobit(const uint64_t *blocks, size_t num_blocks,
     return bitmap_multiblocks_foreach_impl<false>(blocks, num_blocks, f);
 }
 
+// 1M bits per chunk keeps the per-chunk overhead negligible while leaving enough chunks to 
+// balance the workers on large bitmaps
+constexpr size_t DEFAULT_PARALLEL_CHUNK_NUM_BLOCKS = 1 << 14;
+
+// return the number of 1s before each chunk, counted in parallel, and the total at the end
+template<typename ExecutorT>
+_YAEF_ATTR_NODISCARD inline std::vector<size_t> 
+count_chunk_onebit_offsets(const uint64_t *blocks, size_t num_blocks, ExecutorT &exec, size_t chunk_num_blocks) {
+    const size_t num_chunks = idiv_ceil(num_blocks, chunk_num_blocks);
+    std::vector<size_t> offsets(num_chunks + 1, 0);
+    exec(num_chunks, [&](size_t i) {
+        const size_t first = i * chunk_num_blocks;
+        offsets[i + 1] = popcount_range(blocks + first, std::min(chunk_num_blocks, num_blocks - first));
+    });
+    for (size_t i = 0; i < num_chunks; ++i) {
+        offsets[i + 1] += offsets[i];
+    }
+    return offsets;
+}
+
+// write the indices of the 1s to `out` with the chunks decoded by the workers of `exec`, each 
+// one at the offset given by the number of 1s before it. returns the number of 1s.
+template<typename ExecutorT>
+inline size_t parallel_decode_onebits(const uint64_t *blocks, size_t num_blocks, uint64_t *out, ExecutorT &&exec,
+                                      size_t chunk_num_blocks = DEFAULT_PARALLEL_CHUNK_NUM_BLOCKS) {
+    _YAEF_ASSERT(chunk_num_blocks != 0);
+    const std::vector<size_t> offsets = count_chunk_onebit_offsets(blocks, num_blocks, exec, chunk_num_blocks);
+    exec(offsets.size() - 1, [&](size_t i) {
+        const size_t first = i * chunk_num_blocks;
+        (void)decode_onebits(blocks + first, std::min(chunk_num_blocks, num_blocks - first), out + offsets[i], 
+                             offsets[i + 1] - offsets[i], first * 64);
+    });
+    return offsets.back();
+}
+
+// call `f(pos, rank)` for every 1, where `rank` is the number of 1s before `pos`. the calls 
+// are made concurrently by the workers of `exec`, in ascending order within each chunk.
+template<typename F, typename ExecutorT>
+inline size_t parallel_bitmap_foreach_onebit(const uint64_t *blocks, size_t num_blocks, const F &f, ExecutorT &&exec,
+                                             size_t chunk_num_blocks = DEFAULT_PARALLEL_CHUNK_NUM_BLOCKS) {
+    _YAEF_ASSERT(chunk_num_blocks != 0);
+    const std::vector<size_t> offsets = count_chunk_onebit_offsets(blocks, num_blocks, exec, chunk_num_blocks);
+    exec(offsets.size() - 1, [&](size_t i) {
+        const size_t first = i * chunk_num_blocks;
+        size_t rank = offsets[i];
+        bitmap_foreach_onebit(blocks + first, std::min(chunk_num_blocks, num_blocks - first), [&](size_t pos) {
+            f(first * 64 + pos, rank++);
+        });
+    });
+    return offsets.back();
+}
+
 template<bool BitType>
 class bitmap_foreach_cursor {
 public:
@@ -2084,15 +4540,7 @@ public:
     bitmap_foreach_cursor(const uint64_t *blocks, size_type num_blocks) noexcept
         : blocks_beg_(blocks), blocks_end_(blocks + num_blocks), cached_(0) {
         _YAEF_ASSERT(num_blocks != 0);
-        for (const block_type *ptr = blocks_beg_; ptr < blocks_end_; ++ptr) {
-            const block_type block = block_handler{}(*ptr);
-            if (_YAEF_LIKELY(block != 0)) {
-                const auto block_idx = static_cast<size_t>(ptr - blocks_beg_);
-                cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
-                return;
-            }
-        }
-        cached_ = num_blocks * BLOCK_WIDTH;
+        seek_from_block(0);
     }
 
     bitmap_foreach_cursor(const uint64_t *blocks, size_t num_blocks, size_type cached, nocheck_tag) noexcept
@@ -2112,15 +4560,7 @@ public:
             cached_ = num_full_blocks * BLOCK_WIDTH + count_trailing_zero(block);
             return;
         }
-        for (const block_type *ptr = blocks_beg_ + num_full_blocks + 1; ptr < blocks_end_; ++ptr) {
-            const block_type block = block_handler{}(*ptr);
-            if (block != 0) {
-                const auto block_idx = static_cast<size_t>(ptr - blocks_beg_);
-                cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
-                return;
-            }
-        }
-        cached_ = num_blocks * BLOCK_WIDTH;
+        seek_from_block(num_full_blocks + 1);
     }
 
     bitmap_foreach_cursor(const bit_view &bits) noexcept
@@ -2153,18 +4593,44 @@ public:
             cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
             return;
         }
+        seek_from_block(block_idx + 1);
+    }
 
-        for (const block_type *ptr = blocks_beg_ + block_idx + 1; ptr < blocks_end_; ++ptr) {
-            const block_type block = block_handler{}(*ptr);
-            if (_YAEF_LIKELY(block != 0)) {
-                const auto block_idx = static_cast<size_t>(ptr - blocks_beg_);
-                cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
+    // move forward by k wanted bits, whole blocks are skipped by their popcounts
+    void advance_by(size_type k) {
+        _YAEF_ASSERT(is_valid());
+        if (_YAEF_UNLIKELY(k == 0)) { return; }
+
+        size_type block_idx = cached_ / BLOCK_WIDTH;
+        block_type block = block_handler{}(blocks_beg_[block_idx]) & ~bits64::make_mask_lsb1(cached_ % BLOCK_WIDTH + 1);
+        for (const size_type n = num_blocks(); ; block = block_handler{}(blocks_beg_[block_idx])) {
+            const uint32_t popcnt = popcount(block);
+            if (k <= popcnt) {
+                cached_ = block_idx * BLOCK_WIDTH + select_one(block, static_cast<uint32_t>(k - 1));
                 return;
             }
+            k -= popcnt;
+            if (++block_idx == n) { break; }
         }
         cached_ = num_blocks() * BLOCK_WIDTH;
     }
 
+    // move to the first wanted bit at or after `bit_pos`, the cursor never moves backward
+    void skip_to(size_type bit_pos) {
+        if (bit_pos <= cached_) { return; }
+        if (_YAEF_UNLIKELY(bit_pos >= num_blocks() * BLOCK_WIDTH)) {
+            cached_ = num_blocks() * BLOCK_WIDTH;
+            return;
+        }
+        const size_type block_idx = bit_pos / BLOCK_WIDTH;
+        const block_type block = block_handler{}(blocks_beg_[block_idx]) & ~bits64::make_mask_lsb1(bit_pos % BLOCK_WIDTH);
+        if (block != 0) {
+            cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
+            return;
+        }
+        seek_from_block(block_idx + 1);
+    }
+
     void prev() {
         auto msb = [](block_type b) -> uint32_t {
             _YAEF_ASSERT(b != 0);
@@ -2211,6 +4677,27 @@ private:
     _YAEF_ATTR_NODISCARD size_t num_blocks() const {
         return blocks_end_ - blocks_beg_;
     }
+
+    // move to the first wanted bit in the blocks from `block_idx`. the blocks right after it 
+    // are checked inline, longer gaps are skipped by the vectorized block scan.
+    void seek_from_block(size_type block_idx) {
+        constexpr size_type NUM_INLINE_BLOCKS = 4;
+        const size_type n = num_blocks();
+        for (const size_type inline_end = std::min(n, block_idx + NUM_INLINE_BLOCKS); block_idx < inline_end; ++block_idx) {
+            const block_type block = block_handler{}(blocks_beg_[block_idx]);
+            if (_YAEF_LIKELY(block != 0)) {
+                cached_ = block_idx * BLOCK_WIDTH + count_trailing_zero(block);
+                return;
+            }
+        }
+        if (block_idx >= n) {
+            cached_ = n * BLOCK_WIDTH;
+            return;
+        }
+        block_idx += find_block_with_bit(blocks_beg_ + block_idx, n - block_idx, BitType);
+        cached_ = block_idx < n ? block_idx * BLOCK_WIDTH + count_trailing_zero(block_handler{}(blocks_beg_[block_idx])) :
+                                  n * BLOCK_WIDTH;
+    }
 };
 
 using bitmap_foreach_onebit_cursor  = bitmap_foreach_cursor<true>;
@@ -2356,6 +4843,21 @@ duplicate_packed_ints(AllocT &alloc, const bits64::packed_int_view &ints) {
     return result;
 }
 
+// store `transform(*iter)` of the next `ints.size()` values into `ints`, they are staged 
+// in a small buffer so that `set_values` can pack whole groups.
+template<typename InputIterT, typename TransformT>
+inline void fill_packed_ints(bits64::packed_int_view &ints, InputIterT iter, TransformT transform) {
+    constexpr size_t STAGE_SIZE = 256;
+    uint64_t staged[STAGE_SIZE];
+    for (size_t i = 0; i < ints.size(); i += STAGE_SIZE) {
+        const size_t num = std::min(STAGE_SIZE, ints.size() - i);
+        for (size_t j = 0; j < num; ++j, ++iter) {
+            staged[j] = transform(*iter);
+        }
+        ints.set_values(i, i + num, staged);
+    }
+}
+
 template<typename AllocT>
 _YAEF_ATTR_NODISCARD inline bits64::bit_view 
 allocate_uninit_bits(AllocT &alloc, size_t num_elems) {
@@ -2442,7 +4944,11 @@ template<typename AllocT>
 inline error_code bit_view::deserialize(AllocT &alloc, deserializer &deser) {
     size_t num_bits;
     if (!deser.read(num_bits)) { return error_code::deserialize_io; }
+    return deserialize_blocks(alloc, deser, num_bits);
+}
 
+template<typename AllocT>
+inline error_code bit_view::deserialize_blocks(AllocT &alloc, deserializer &deser, size_type num_bits) {
     auto tmp = yaef::details::allocate_uninit_bits(alloc, num_bits);
     if (!deser.read_bytes(reinterpret_cast<uint8_t *>(tmp.blocks_), sizeof(block_type) * tmp.num_blocks())) {
         yaef::details::deallocate_bits(alloc, tmp);
@@ -2536,11 +5042,7 @@ public:
     void unchecked_enocde_low_bits(uint64_t *buf_out) const {
         bits64::packed_int_view view{low_width_, buf_out, size_};
         view.clear_all_bits();
-
-        auto iter = first_;
-        for (size_type i = 0; i < size_; ++i, ++iter) {
-            view.set_value(i, to_stored_value(*iter));
-        }
+        fill_packed_ints(view, first_, [this](value_type val) { return to_stored_value(val); });
     }
 
     void unchecked_encode_high_bits(uint64_t *buf_out) const {
@@ -2618,18 +5120,176 @@ private:
     T value_;
 };
 
-class selectable_dense_bits {
+// a bitvector with select indexes on both the 1s and the 0s, sampled as `SamplingPolicy` describes
+template<typename SamplingPolicy>
+class basic_selectable_dense_bits {
 public:
     using size_type = size_t;
+    using sampling_policy = SamplingPolicy;
+
+private:
+    static constexpr uint64_t POLICY_SAMPLE_RATE      = SamplingPolicy::SAMPLE_RATE;
+    static constexpr uint64_t POLICY_SUBSAMPLE_RATE   = SamplingPolicy::SUBSAMPLE_RATE;
+    static constexpr uint64_t POLICY_EACH_ONE_MIN_LEN = SamplingPolicy::EACH_ONE_MIN_LEN;
+
+    static constexpr size_type SELECT_INLINE_SCAN_NUM_BLOCKS = 2;
+    static constexpr size_type SELECT_BATCH_GROUP_SIZE       = 16;
+
+    // the serialized form starts with a header word, a magic number in the upper 48 bits and 
+    // the format version in the lower 16 bits, followed by a word of flags, whose low 2 bits 
+    // hold the sampled `select_sides`. before 0.2.0 the 
+    // bits came first without a header, their size never has the top bit set, so such data 
+    // is still recognized and loaded.
+    static constexpr uint64_t SERIALIZE_MAGIC                = UINT64_C(0xB1755E1EC7AB);
+    static constexpr uint64_t SERIALIZE_VERSION              = 1;
+    static constexpr uint64_t SERIALIZE_HEADER               = (SERIALIZE_MAGIC << 16) | SERIALIZE_VERSION;
+    static constexpr uint64_t SERIALIZE_FLAGS_SIDES_MASK     = 3u;
+    static constexpr uint64_t SERIALIZE_FLAG_SELECT_SAMPLES  = 1u << 2;
+    static constexpr uint64_t SERIALIZE_FLAG_RANK_DIRECTORY  = 1u << 3;
+    static constexpr uint64_t SERIALIZE_KNOWN_FLAGS          = SERIALIZE_FLAGS_SIDES_MASK | SERIALIZE_FLAG_SELECT_SAMPLES | 
+                                                               SERIALIZE_FLAG_RANK_DIRECTORY;
+
+    // the flags word is followed by the sampling parameters, so that the samples are never 
+    // read back with another policy
+    struct serialized_header {
+        uint64_t magic_and_version;
+        uint64_t flags;
+        uint64_t sample_rate;
+        uint64_t subsample_rate;
+        uint64_t each_one_min_len;
+    };
+
+    struct position_samples;
 
 public:
-    selectable_dense_bits() = default;
+    basic_selectable_dense_bits() = default;
+
+    template<typename AllocT>
+    basic_selectable_dense_bits(AllocT &alloc, bits64::bit_view bits, bits64::bits_stat_info stat_info, 
+                                select_sides sides = SamplingPolicy::SIDES)   
+        : bits_(bits), sides_(sides) {
+        build_samples(alloc, stat_info, sides, zero_samples_, one_samples_);
+    }
+
+    template<typename AllocT>
+    basic_selectable_dense_bits(AllocT &alloc, bits64::bit_view bits, select_sides sides = SamplingPolicy::SIDES)
+        : basic_selectable_dense_bits(alloc, bits, bits64::stats_bits(bits), sides) { }
+
+    template<typename AllocT>
+    void deallocate(AllocT &alloc) {
+        deallocate_bits(alloc, bits_);
+        zero_samples_.deallocate(alloc);
+        one_samples_.deallocate(alloc);
+        rank_directory_.deallocate(alloc);
+        if (lazy_samples_ != nullptr) {
+            lazy_samples_->zero_samples.deallocate(alloc);
+            lazy_samples_->one_samples.deallocate(alloc);
+            lazy_samples_.reset();
+        }
+    }
+
+    template<typename AllocT>
+    _YAEF_ATTR_NODISCARD basic_selectable_dense_bits duplicate(AllocT &alloc) const {
+        auto new_bits = duplicate_bits(alloc, bits_);
+        auto new_rank_directory = rank_directory_.duplicate(alloc);
+        if (needs_select_samples()) {
+            // the copy builds its own samples on demand
+            basic_selectable_dense_bits copy{new_bits, sides_, position_samples{}, position_samples{}, new_rank_directory};
+            copy.lazy_samples_ = std::make_shared<lazy_samples_state>();
+            return copy;
+        }
+        auto new_zero_samples = get_samples<false>().duplicate(alloc);
+        auto new_one_samples = get_samples<true>().duplicate(alloc);
+        return basic_selectable_dense_bits{new_bits, sides_, new_zero_samples, new_one_samples, new_rank_directory};
+    }
+
+    // the samples of the other side can be added to a one-sided index later
+    template<typename AllocT>
+    void build_select_samples(AllocT &alloc, select_sides sides) {
+        const auto missing_sides = static_cast<select_sides>(
+            static_cast<uint32_t>(sides) & ~static_cast<uint32_t>(sides_));
+        if (static_cast<uint32_t>(missing_sides) != 0) {
+            if (lazy_samples_ != nullptr) {
+                // complete the samples shared with the shallow copies
+                ensure_select_samples(alloc);
+                build_samples(alloc, bits64::stats_bits(bits_), missing_sides, 
+                              lazy_samples_->zero_samples, lazy_samples_->one_samples);
+            } else {
+                build_samples(alloc, bits64::stats_bits(bits_), missing_sides, zero_samples_, one_samples_);
+            }
+            sides_ = static_cast<select_sides>(static_cast<uint32_t>(sides_) | static_cast<uint32_t>(sides));
+        }
+    }
+
+    // true if the bits were loaded with `deserialize_flags::lazy_select_samples` and no select 
+    // has built the samples yet
+    _YAEF_ATTR_NODISCARD bool needs_select_samples() const noexcept {
+        return lazy_samples_ != nullptr && !lazy_samples_->ready.load(std::memory_order_acquire);
+    }
+
+    // build the samples of bits loaded without them, it must be called before the first select. 
+    // it may be called by many threads at once, the first call builds the samples and the others 
+    // wait for it. the allocation may throw, then a later call tries again.
+    template<typename AllocT>
+    void ensure_select_samples(AllocT &alloc) const {
+        if (_YAEF_LIKELY(!needs_select_samples())) {
+            return;
+        }
+        lazy_samples_state &state = *lazy_samples_;
+        std::call_once(state.once, [this, &alloc, &state]() {
+            build_samples(alloc, bits64::stats_bits(bits_), sides_, state.zero_samples, state.one_samples);
+            state.ready.store(true, std::memory_order_release);
+        });
+    }
+
+    _YAEF_ATTR_NODISCARD select_sides get_select_sides() const noexcept { return sides_; }
+
+    _YAEF_ATTR_NODISCARD bool has_select_samples(select_sides sides) const noexcept {
+        return has_select_side(sides_, sides);
+    }
+
+private:
+    // feed the positions of the 1s (or 0s) to `f` in order, the padding of the last block is skipped
+    template<bool BitType, typename F>
+    void foreach_bit(const F &f) const {
+        const size_type num_bits = bits_.size();
+        auto visit = [&f, num_bits](size_type pos) {
+            if (_YAEF_LIKELY(pos < num_bits)) { f(pos); }
+        };
+        if _YAEF_CXX17_CONSTEXPR (BitType) {
+            bits64::bitmap_foreach_onebit(bits_.blocks(), bits_.num_blocks(), visit);
+        } else {
+            bits64::bitmap_foreach_zerobit(bits_.blocks(), bits_.num_blocks(), visit);
+        }
+    }
+
+    // the layout before 0.2.0, the bits and the samples of both sides. the samples were built with 
+    // the default policy by an older sampling pass, so they are skipped and built again.
+    template<typename AllocT>
+    error_code deserialize_unversioned(AllocT &alloc, deserializer &deser, uint64_t num_bits) {
+        _YAEF_RETURN_ERR_IF_FAIL(bits_.deserialize_blocks(alloc, deser, num_bits));
+        for (int i = 0; i < 2; ++i) {
+            position_samples old_samples;
+            _YAEF_RETURN_ERR_IF_FAIL(old_samples.deserialize(alloc, deser));
+            old_samples.deallocate(alloc);
+        }
+        sides_ = SamplingPolicy::SIDES;
+        zero_samples_ = position_samples{};
+        one_samples_ = position_samples{};
+        rank_directory_ = rank_directory{};
+        lazy_samples_.reset();
+        build_samples(alloc, bits64::stats_bits(bits_), sides_, zero_samples_, one_samples_);
+        return error_code::success;
+    }
 
+    // build the samples of `sides` into `zero_samples` and `one_samples`, the others are left untouched
     template<typename AllocT>
-    selectable_dense_bits(AllocT &alloc, bits64::bit_view bits, bits64::bits_stat_info stat_info)   
-        : bits_(bits) {
+    void build_samples(AllocT &alloc, bits64::bits_stat_info stat_info, select_sides sides,
+                       position_samples &zero_samples, position_samples &one_samples) const {
         _YAEF_STATIC_ASSERT_NOMSG(std::is_same<typename std::allocator_traits<AllocT>::value_type, uint8_t>::value);
-        
+        const bool sample_ones = has_select_side(sides, select_sides::ones);
+        const bool sample_zeros = has_select_side(sides, select_sides::zeros);
+
         // `sampler` is used to handle primary samples and allocate memory for subsamples.
         struct sampler {
             sampler(AllocT &alloc, size_type num_bits, size_type num_zeros_or_ones)
@@ -2736,20 +5396,21 @@ public:
         const size_type num_ones = stat_info.num_ones();
         const size_type num_zeros = stat_info.num_zeros();
 
-        sampler one_sampler{alloc, bits.size(), num_ones};
-        sampler zero_sampler{alloc, bits.size(), num_zeros};
-
-        // sample bit-1 and bit-0 respectively.
-        for (size_type i = 0; i < bits.size(); ++i) {
-            if (bits.get_bit(i) == true) {
-                one_sampler.try_sample(i);
-            } else { 
-                zero_sampler.try_sample(i);
+        // sample bit-1 and bit-0 respectively, only the requested sides are touched.
+        if (sample_ones) {
+            sampler one_sampler{alloc, bits_.size(), num_ones};
+            if (num_ones != 0) {
+                foreach_bit<true>([&one_sampler](size_type pos) { one_sampler.try_sample(pos); });
             }
+            one_samples = one_sampler.finish();
+        }
+        if (sample_zeros) {
+            sampler zero_sampler{alloc, bits_.size(), num_zeros};
+            if (num_zeros != 0) {
+                foreach_bit<false>([&zero_sampler](size_type pos) { zero_sampler.try_sample(pos); });
+            }
+            zero_samples = zero_sampler.finish();
         }
-        
-        one_samples_ = one_sampler.finish();
-        zero_samples_ = zero_sampler.finish();
 
         // `subsampler` is used to complete the remaining subsampling.
         struct subsampler {
@@ -2791,40 +5452,30 @@ public:
             position_samples samples_;
         };
         
-        subsampler one_subsampler{one_samples_};
-        subsampler zero_subsampler{zero_samples_};
-        bool need_init_one_subsamples = !one_samples_.get_subsample_block_infos().empty();
-        bool need_init_zero_subsamples = !zero_samples_.get_subsample_block_infos().empty();
-
-        for (size_type i = 0; i < bits.size(); ++i) {
-            if (need_init_one_subsamples && bits.get_bit(i) == true) {
-                one_subsampler.try_sample(i);
-            } else if (need_init_zero_subsamples) {
-                zero_subsampler.try_sample(i);
-            }
+        if (sample_ones && !one_samples.get_subsample_block_infos().empty()) {
+            subsampler one_subsampler{one_samples};
+            foreach_bit<true>([&one_subsampler](size_type pos) { one_subsampler.try_sample(pos); });
+            one_samples = one_subsampler.finish();
+        }
+        if (sample_zeros && !zero_samples.get_subsample_block_infos().empty()) {
+            subsampler zero_subsampler{zero_samples};
+            foreach_bit<false>([&zero_subsampler](size_type pos) { zero_subsampler.try_sample(pos); });
+            zero_samples = zero_subsampler.finish();
         }
-        one_samples_ = one_subsampler.finish();
-        zero_samples_ = zero_subsampler.finish();
     }
 
-    template<typename AllocT>
-    selectable_dense_bits(AllocT &alloc, bits64::bit_view bits)
-        : selectable_dense_bits(alloc, bits, bits64::stats_bits(bits)) { }
+public:
 
+    // the rank directory is optional, it is only built on demand since most users 
+    // of `basic_selectable_dense_bits` only select
     template<typename AllocT>
-    void deallocate(AllocT &alloc) {
-        deallocate_bits(alloc, bits_);
-        zero_samples_.deallocate(alloc);
-        one_samples_.deallocate(alloc);
+    void build_rank_directory(AllocT &alloc) {
+        if (!has_rank_directory()) {
+            rank_directory_ = rank_directory{alloc, bits_};
+        }
     }
 
-    template<typename AllocT>
-    _YAEF_ATTR_NODISCARD selectable_dense_bits duplicate(AllocT &alloc) const {
-        auto new_bits = duplicate_bits(alloc, bits_);
-        auto new_zero_samples = zero_samples_.duplicate(alloc);
-        auto new_one_samples = one_samples_.duplicate(alloc);
-        return selectable_dense_bits{new_bits, new_zero_samples, new_one_samples};
-    }
+    _YAEF_ATTR_NODISCARD bool has_rank_directory() const noexcept { return !rank_directory_.empty(); }
 
     _YAEF_ATTR_NODISCARD size_type size() const noexcept { return bits_.size(); }
 
@@ -2832,41 +5483,133 @@ public:
 
     _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
         return bits_.space_usage_in_bytes() +
-               zero_samples_.space_usage_in_bytes() +
-               one_samples_.space_usage_in_bytes();
+               get_samples<false>().space_usage_in_bytes() +
+               get_samples<true>().space_usage_in_bytes() +
+               rank_directory_.space_usage_in_bytes();
+    }
+
+    // requires the samples of the 1s, built by `ensure_select_samples` if they were not loaded
+    _YAEF_ATTR_NODISCARD size_type select_one(size_type rank) const noexcept {
+        _YAEF_ASSERT(has_select_samples(select_sides::ones) && !needs_select_samples());
+        return select_impl<true>(rank);
+    }
+
+    // requires the samples of the 0s
+    _YAEF_ATTR_NODISCARD size_type select_zero(size_type rank) const noexcept {
+        _YAEF_ASSERT(has_select_samples(select_sides::zeros) && !needs_select_samples());
+        return select_impl<false>(rank);
+    }
+
+    // `out[i] = select_one(ranks[i])` for i in [0, n). the three dependent loads of a select 
+    // (sample, subsample, bits) are issued in stages over a group of ranks, so that the cache 
+    // misses of the group overlap.
+    void select_one_batch(const size_type *ranks, size_type n, size_type *out) const noexcept {
+        _YAEF_ASSERT(has_select_samples(select_sides::ones) && !needs_select_samples());
+        select_batch_impl<true>(ranks, n, out);
+    }
+
+    void select_zero_batch(const size_type *ranks, size_type n, size_type *out) const noexcept {
+        _YAEF_ASSERT(has_select_samples(select_sides::zeros) && !needs_select_samples());
+        select_batch_impl<false>(ranks, n, out);
     }
 
-    _YAEF_ATTR_NODISCARD size_type select_one(size_type rank) const noexcept {
-        return select_impl<true>(rank);
+    // return the number of 1s in [0, index), requires `build_rank_directory`
+    _YAEF_ATTR_NODISCARD size_type rank_one(size_type index) const noexcept {
+        _YAEF_ASSERT(has_rank_directory());
+        _YAEF_ASSERT(index <= size());
+        return rank_directory_.rank_one(bits_, index);
     }
 
-    _YAEF_ATTR_NODISCARD size_type select_zero(size_type rank) const noexcept {
-        return select_impl<false>(rank);
+    _YAEF_ATTR_NODISCARD size_type rank_zero(size_type index) const noexcept {
+        return index - rank_one(index);
     }
 
-    void swap(selectable_dense_bits &other) noexcept {
+    void swap(basic_selectable_dense_bits &other) noexcept {
         bits_.swap(other.bits_);
+        std::swap(sides_, other.sides_);
+        lazy_samples_.swap(other.lazy_samples_);
         zero_samples_.swap(other.zero_samples_);
         one_samples_.swap(other.one_samples_);
+        rank_directory_.swap(other.rank_directory_);
+    }
+
+    _YAEF_ATTR_NODISCARD friend bool 
+    operator==(const basic_selectable_dense_bits &lhs, const basic_selectable_dense_bits &rhs) noexcept {
+        if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
+            return true;
+        }
+        // the samples and the rank directory are derived from the bits, and the samples 
+        // may not be built yet
+        return lhs.bits_ == rhs.bits_ && lhs.sides_ == rhs.sides_;
     }
 
-    friend bool operator==(const selectable_dense_bits &lhs, const selectable_dense_bits &rhs) noexcept;
 #if __cplusplus < 202002L
-    friend bool operator!=(const selectable_dense_bits &lhs, const selectable_dense_bits &rhs) noexcept;
+    _YAEF_ATTR_NODISCARD friend bool 
+    operator!=(const basic_selectable_dense_bits &lhs, const basic_selectable_dense_bits &rhs) noexcept {
+        return !(lhs == rhs);
+    }
 #endif
 
     error_code serialize(serializer &ser) const {
+        const bool with_samples = !ser.has_flags(serialize_flags::omit_select_samples) && !needs_select_samples();
+        uint64_t flags = static_cast<uint64_t>(sides_);
+        if (with_samples) { flags |= SERIALIZE_FLAG_SELECT_SAMPLES; }
+        if (has_rank_directory()) { flags |= SERIALIZE_FLAG_RANK_DIRECTORY; }
+        const serialized_header header{
+            SERIALIZE_HEADER, flags, POLICY_SAMPLE_RATE, POLICY_SUBSAMPLE_RATE, POLICY_EACH_ONE_MIN_LEN
+        };
+        if (!ser.write(header)) { return error_code::serialize_io; }
         _YAEF_RETURN_ERR_IF_FAIL(bits_.serialize(ser));
-        _YAEF_RETURN_ERR_IF_FAIL(zero_samples_.serialize(ser));
-        _YAEF_RETURN_ERR_IF_FAIL(one_samples_.serialize(ser));
+        if (with_samples) {
+            _YAEF_RETURN_ERR_IF_FAIL(get_samples<false>().serialize(ser));
+            _YAEF_RETURN_ERR_IF_FAIL(get_samples<true>().serialize(ser));
+        }
+        if (has_rank_directory()) {
+            _YAEF_RETURN_ERR_IF_FAIL(rank_directory_.serialize(ser));
+        }
         return error_code::success;
     }
 
     template<typename AllocT>
     error_code deserialize(AllocT &alloc, deserializer &deser) {
+        serialized_header header{};
+        if (!deser.read(header.magic_and_version)) { return error_code::deserialize_io; }
+        if ((header.magic_and_version >> 16) != SERIALIZE_MAGIC) {
+            return deserialize_unversioned(alloc, deser, header.magic_and_version);
+        }
+        if (header.magic_and_version != SERIALIZE_HEADER) { return error_code::deserialize_invalid_format; }
+        if (!deser.read(header.flags) || !deser.read(header.sample_rate) || 
+            !deser.read(header.subsample_rate) || !deser.read(header.each_one_min_len)) {
+            return error_code::deserialize_io;
+        }
+        if ((header.flags & ~SERIALIZE_KNOWN_FLAGS) != 0) { return error_code::deserialize_invalid_format; }
+        if (header.sample_rate != POLICY_SAMPLE_RATE || header.subsample_rate != POLICY_SUBSAMPLE_RATE ||
+            header.each_one_min_len != POLICY_EACH_ONE_MIN_LEN) {
+            return error_code::deserialize_mismatched_policy;
+        }
+        const uint64_t sides = header.flags & SERIALIZE_FLAGS_SIDES_MASK;
+        if (sides == 0) { return error_code::deserialize_invalid_format; }
+        sides_ = static_cast<select_sides>(sides);
         _YAEF_RETURN_ERR_IF_FAIL(bits_.deserialize(alloc, deser));
-        _YAEF_RETURN_ERR_IF_FAIL(zero_samples_.deserialize(alloc, deser));
-        _YAEF_RETURN_ERR_IF_FAIL(one_samples_.deserialize(alloc, deser));
+        if ((header.flags & SERIALIZE_FLAG_SELECT_SAMPLES) != 0) {
+            _YAEF_RETURN_ERR_IF_FAIL(zero_samples_.deserialize(alloc, deser));
+            _YAEF_RETURN_ERR_IF_FAIL(one_samples_.deserialize(alloc, deser));
+            lazy_samples_.reset();
+        } else {
+            zero_samples_ = position_samples{};
+            one_samples_ = position_samples{};
+            if (deser.has_flags(deserialize_flags::lazy_select_samples)) {
+                lazy_samples_ = std::make_shared<lazy_samples_state>();
+            } else {
+                lazy_samples_.reset();
+                build_samples(alloc, bits64::stats_bits(bits_), sides_, zero_samples_, one_samples_);
+            }
+        }
+        if ((header.flags & SERIALIZE_FLAG_RANK_DIRECTORY) != 0) {
+            _YAEF_RETURN_ERR_IF_FAIL(rank_directory_.deserialize(alloc, deser));
+        } else {
+            rank_directory_ = rank_directory{};
+        }
         return error_code::success;
     }
 
@@ -2876,10 +5619,10 @@ private:
             uniform = 0, each_one = 1
         };
 
-        static constexpr size_type SAMPLE_RATE                        = static_cast<size_type>(1) << 12;
-        static constexpr size_type UNIFORM_SUBSAMPLE_RATE             = 64;
+        static constexpr size_type SAMPLE_RATE                        = SamplingPolicy::SAMPLE_RATE;
+        static constexpr size_type UNIFORM_SUBSAMPLE_RATE             = SamplingPolicy::SUBSAMPLE_RATE;
         static constexpr size_type UNIFORM_SUBSAMPLE_BLOCK_NUM_ELEMS  = SAMPLE_RATE / UNIFORM_SUBSAMPLE_RATE;
-        static constexpr size_type EACH_ONE_SUBSAMPLE_MIN_LEN         = static_cast<size_type>(1) << 16;
+        static constexpr size_type EACH_ONE_SUBSAMPLE_MIN_LEN         = SamplingPolicy::EACH_ONE_MIN_LEN;
         static constexpr size_type EACH_ONE_SUBSAMPLE_BLOCK_NUM_ELEMS = SAMPLE_RATE; 
 
         struct sample_find_result {
@@ -2948,26 +5691,65 @@ private:
             return subsample_info_;
         }
 
-        _YAEF_ATTR_NODISCARD sample_find_result 
-        lookup_subsample(size_type block_index, size_type block_offset) const noexcept {
+        // where the subsample of the `block_offset`-th rank of a sample block is stored, 
+        // `index` is invalid if the rank is closer to the sample than to any subsample
+        struct subsample_location {
+            subsampler_type type;
+            size_type       index;
+            size_type       rank_distance;
+            bool            has_subsample;
+        };
+
+        _YAEF_ATTR_NODISCARD subsample_location 
+        locate_subsample(size_type block_index, size_type block_offset) const noexcept {
             auto subsample_block_info = get_subsample_block_info(block_index);
             subsampler_type type = subsample_block_info.first;
             size_type subsample_index = subsample_block_info.second;
-            const bits64::packed_int_view &subsamples = get_subsamples(type);
-            
-            size_type subsample_rank_distance = 0;
+
             if (type == subsampler_type::uniform) {
                 const size_type mini_block_index = block_offset / UNIFORM_SUBSAMPLE_RATE,
                                 mini_block_offset = block_offset % UNIFORM_SUBSAMPLE_RATE;
                 if (_YAEF_UNLIKELY(mini_block_index == 0)) {
-                    return sample_find_result{mini_block_offset, 0};
+                    return subsample_location{type, 0, mini_block_offset, false};
                 }
                 subsample_index = subsample_index * (UNIFORM_SUBSAMPLE_BLOCK_NUM_ELEMS - 1) + mini_block_index - 1;
-                subsample_rank_distance = mini_block_offset;
+                return subsample_location{type, subsample_index, mini_block_offset, true};
             } else /*if (type == subsampler_type::each_one)*/ {
                 subsample_index = subsample_index * (EACH_ONE_SUBSAMPLE_BLOCK_NUM_ELEMS - 1) + block_offset - 1;
+                return subsample_location{type, subsample_index, 0, true};
+            }
+        }
+
+        _YAEF_ATTR_NODISCARD sample_find_result 
+        lookup_subsample(size_type block_index, size_type block_offset) const noexcept {
+            auto location = locate_subsample(block_index, block_offset);
+            if (!location.has_subsample) {
+                return sample_find_result{location.rank_distance, 0};
+            }
+            return sample_find_result{location.rank_distance, get_subsamples(location.type).get_value(location.index)};
+        }
+
+        // the first two loads of `find_nearest_sample`, for batches of ranks. the sample and 
+        // the subsample info of a rank can be prefetched together, the subsample only once 
+        // the subsample info is loaded.
+        void prefetch_sample(size_type rank) const noexcept {
+            const size_type block_index = rank / SAMPLE_RATE;
+            samples_.prefetch_for_read(block_index, block_index);
+            if (rank % SAMPLE_RATE != 0) {
+                subsample_info_.prefetch_for_read(block_index, block_index);
+            }
+        }
+
+        void prefetch_subsample(size_type rank) const noexcept {
+            const size_type block_index = rank / SAMPLE_RATE, 
+                            block_offset = rank % SAMPLE_RATE;
+            if (block_offset == 0) {
+                return;
+            }
+            auto location = locate_subsample(block_index, block_offset);
+            if (location.has_subsample) {
+                get_subsamples(location.type).prefetch_for_read(location.index, location.index);
             }
-            return sample_find_result{subsample_rank_distance, subsamples.get_value(subsample_index)};
         }
 
         _YAEF_ATTR_NODISCARD sample_find_result find_nearest_sample(size_type rank) const noexcept {
@@ -3028,20 +5810,139 @@ private:
         bits64::packed_int_view subsample_info_;
     };
 
-    bits64::bit_view bits_;
-    position_samples zero_samples_;
-    position_samples one_samples_;
+    // a rank9 directory, two words per superblock of 512 bits: the number of 1s before the 
+    // superblock, and the numbers of 1s before its last 7 blocks relative to the superblock, 
+    // 9 bits each.
+    struct rank_directory {
+        static constexpr size_type SUPERBLOCK_NUM_BLOCKS = 8;
+        static constexpr uint32_t  RELATIVE_COUNT_WIDTH = 9;
+
+        rank_directory() = default;
+
+        explicit rank_directory(bits64::packed_int_view counts) noexcept
+            : counts_(counts) { }
+
+        template<typename AllocT>
+        rank_directory(AllocT &alloc, const bits64::bit_view &bits) {
+            constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+            const size_type num_blocks = bits.num_blocks();
+            const size_type num_superblocks = num_blocks / SUPERBLOCK_NUM_BLOCKS + 1;
+            counts_ = allocate_packed_ints(alloc, 64, 2 * num_superblocks);
+
+            uint64_t *entries = counts_.blocks();
+            size_type num_ones = 0;
+            for (size_type s = 0; s < num_superblocks; ++s) {
+                uint64_t relative_counts = 0;
+                size_type relative_num_ones = 0;
+                for (size_type j = 0; j < SUPERBLOCK_NUM_BLOCKS; ++j) {
+                    if (j != 0) {
+                        relative_counts |= static_cast<uint64_t>(relative_num_ones) << ((j - 1) * RELATIVE_COUNT_WIDTH);
+                    }
+                    const size_type block_index = s * SUPERBLOCK_NUM_BLOCKS + j;
+                    if (block_index < num_blocks) {
+                        uint64_t block = bits.blocks()[block_index];
+                        if (block_index == num_blocks - 1 && bits.size() % BITS_BLOCK_WIDTH != 0) {
+                            block &= bits64::make_mask_lsb1(bits.size() % BITS_BLOCK_WIDTH);
+                        }
+                        relative_num_ones += bits64::popcount(block);
+                    }
+                }
+                entries[2 * s] = num_ones;
+                entries[2 * s + 1] = relative_counts;
+                num_ones += relative_num_ones;
+            }
+        }
+
+        template<typename AllocT>
+        void deallocate(AllocT &alloc) {
+            deallocate_packed_ints(alloc, counts_);
+            counts_ = bits64::packed_int_view{};
+        }
+
+        template<typename AllocT>
+        _YAEF_ATTR_NODISCARD rank_directory duplicate(AllocT &alloc) const {
+            return rank_directory{duplicate_packed_ints(alloc, counts_)};
+        }
+
+        _YAEF_ATTR_NODISCARD bool empty() const noexcept { return counts_.size() == 0; }
+
+        _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
+            return counts_.space_usage_in_bytes();
+        }
+
+        _YAEF_ATTR_NODISCARD size_type rank_one(const bits64::bit_view &bits, size_type index) const noexcept {
+            constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+            const size_type block_index = index / BITS_BLOCK_WIDTH,
+                            block_offset = index % BITS_BLOCK_WIDTH;
+            const size_type superblock_index = block_index / SUPERBLOCK_NUM_BLOCKS,
+                            superblock_offset = block_index % SUPERBLOCK_NUM_BLOCKS;
+            const uint64_t *entries = counts_.blocks();
+
+            size_type res = entries[2 * superblock_index];
+            if (superblock_offset != 0) {
+                res += (entries[2 * superblock_index + 1] >> ((superblock_offset - 1) * RELATIVE_COUNT_WIDTH)) & 
+                       bits64::make_mask_lsb1(RELATIVE_COUNT_WIDTH);
+            }
+            if (block_offset != 0) {
+                res += bits64::popcount(bits.blocks()[block_index] & bits64::make_mask_lsb1(block_offset));
+            }
+            return res;
+        }
+
+        void swap(rank_directory &other) noexcept {
+            counts_.swap(other.counts_);
+        }
+
+        _YAEF_ATTR_NODISCARD friend bool operator==(const rank_directory &lhs, const rank_directory &rhs) noexcept {
+            return lhs.counts_ == rhs.counts_;
+        }
+
+#if __cplusplus < 202002L
+        _YAEF_ATTR_NODISCARD friend bool operator!=(const rank_directory &lhs, const rank_directory &rhs) noexcept {
+            return !(lhs == rhs);
+        }
+#endif
+
+        error_code serialize(serializer &ser) const {
+            return counts_.serialize(ser);
+        }
+
+        template<typename AllocT>
+        error_code deserialize(AllocT &alloc, deserializer &deser) {
+            return counts_.deserialize(alloc, deser);
+        }
+
+    private:
+        bits64::packed_int_view counts_;
+    };
+
+    // the samples of bits loaded with `deserialize_flags::lazy_select_samples`, built on first 
+    // use. the shallow copies share the state, so they also share the samples once built.
+    struct lazy_samples_state {
+        std::once_flag    once;
+        std::atomic<bool> ready{false};
+        position_samples  zero_samples;
+        position_samples  one_samples;
+    };
+
+    bits64::bit_view                    bits_;
+    select_sides                        sides_ = select_sides::both;
+    std::shared_ptr<lazy_samples_state> lazy_samples_;
+    position_samples                    zero_samples_;
+    position_samples                    one_samples_;
+    rank_directory                      rank_directory_;
 
-    selectable_dense_bits(bits64::bit_view bits, const position_samples &zero_samples,
-                          const position_samples &one_samples)
-        : bits_(bits), zero_samples_(zero_samples), one_samples_(one_samples) { }
+    basic_selectable_dense_bits(bits64::bit_view bits, select_sides sides, const position_samples &zero_samples,
+                                const position_samples &one_samples, const rank_directory &rank_dir)
+        : bits_(bits), sides_(sides), zero_samples_(zero_samples), one_samples_(one_samples), 
+          rank_directory_(rank_dir) { }
 
     _YAEF_ATTR_NODISCARD const position_samples &get_samples_impl(std::true_type) const noexcept { 
-        return one_samples_; 
+        return _YAEF_LIKELY(lazy_samples_ == nullptr) ? one_samples_ : lazy_samples_->one_samples; 
     }
 
     _YAEF_ATTR_NODISCARD const position_samples &get_samples_impl(std::false_type) const noexcept { 
-        return zero_samples_; 
+        return _YAEF_LIKELY(lazy_samples_ == nullptr) ? zero_samples_ : lazy_samples_->zero_samples; 
     }
     
     template<bool BitType>
@@ -3049,74 +5950,133 @@ private:
         return get_samples_impl(std::integral_constant<bool, BitType>{});
     }
 
+public:
     struct memory_access_stats {
+        // the per-word popcounts of the sampled block and the inline blocks
         size_type num_popcount = 0;
         size_type num_select = 0;
+        size_type num_cache_lines = 0;
+        // the 8-word steps of `select_{one,zero}_blocks`, including the one that holds the target
+        size_type num_kernel_steps = 0;
+        // the block of the sampled position, where the scan starts
+        size_type first_block_index = 0;
 
         memory_access_stats() = default;
 
-        memory_access_stats(size_type p, size_type s) noexcept
-            : num_popcount(p), num_select(s) { }
+        memory_access_stats(size_type p, size_type s, size_type c = 0, size_type k = 0) noexcept
+            : num_popcount(p), num_select(s), num_cache_lines(c), num_kernel_steps(k) { }
     };
 
-    // !!!(dev-only) this method is used to count the number of memory accesses 
-    // and popcounts/select_in_word performed during a `select` operation
+private:
+    // !!!(dev-only) this method mirrors `select_from_sample` to count the popcounts/select_in_word 
+    // of the inline scan, the steps of the blocks kernel, and the number of cache lines of the bits 
+    // the scan touches. a kernel step reads its whole 8-word group, or the rest of the bits.
     template<bool BitType>
     _YAEF_ATTR_NODISCARD memory_access_stats select_impl_scan_stats(size_type rank) const noexcept {        
-        const auto &samples = BitType ? one_samples_ : zero_samples_;
-        
-        auto find = samples.find_nearest_sample(rank);
+        using block_handler = bits64::conditional_bitwise_not<!BitType>;
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        constexpr size_type KERNEL_STEP_NUM_BLOCKS = 8;
+
+        auto find = get_samples<BitType>().find_nearest_sample(rank);
         if (find.rank_distance == 0) {
             return memory_access_stats{0, 0};
         }
         
-        using bits_block_type = bits64::bit_view::block_type;
-        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
         const size_type bits_block_index = (find.position + 1) / BITS_BLOCK_WIDTH,
                         bits_block_offset = (find.position + 1) % BITS_BLOCK_WIDTH;
         const size_type num_bits_block = bits_.num_blocks();
 
-        auto bitwise_not_if_select_zero = [](bits_block_type b) -> bits_block_type {
-            if _YAEF_CXX17_CONSTEXPR (BitType) { 
-                return b;
-            } else { 
-                return ~b;
-            }
+        auto count_cache_lines = [this, bits_block_index](size_type last_block_index) -> size_type {
+            constexpr uintptr_t CACHE_LINE_SIZE = 64;
+            const uintptr_t first_addr = reinterpret_cast<uintptr_t>(bits_.blocks() + bits_block_index),
+                            last_addr = reinterpret_cast<uintptr_t>(bits_.blocks() + last_block_index);
+            return static_cast<size_type>(last_addr / CACHE_LINE_SIZE - first_addr / CACHE_LINE_SIZE + 1);
         };
 
-        bits_block_type bits_block = bitwise_not_if_select_zero(bits_.blocks()[bits_block_index]) >> bits_block_offset;
-
         memory_access_stats stats;
-        {
-            uint32_t popcnt = bits64::popcount(bits_block);
+        stats.first_block_index = bits_block_index;
+        // the sampled block, then the inline blocks
+        const size_type inline_scan_end = std::min(bits_block_index + 1 + SELECT_INLINE_SCAN_NUM_BLOCKS, 
+                                                   num_bits_block);
+        size_type i = bits_block_index;
+        for (; i < inline_scan_end; ++i) {
+            uint64_t bits_block = block_handler{}(bits_.blocks()[i]);
+            if (i == bits_block_index) {
+                bits_block >>= bits_block_offset;
+            }
+            const uint32_t popcnt = bits64::popcount(bits_block);
             ++stats.num_popcount;
-            if (popcnt < find.rank_distance) {
-                find.rank_distance -= popcnt;
-            } else {
+            if (popcnt >= find.rank_distance) {
                 ++stats.num_select;
+                stats.num_cache_lines = count_cache_lines(i);
                 return stats;
             }
+            find.rank_distance -= popcnt;
         }
-        for (size_type i = bits_block_index + 1; i < num_bits_block; ++i) {
-            bits_block = bitwise_not_if_select_zero(bits_.blocks()[i]);
-            uint32_t popcnt = bits64::popcount(bits_block);
-            if (popcnt < find.rank_distance) {
-                find.rank_distance -= popcnt;
-                ++stats.num_popcount;
-            } else {
+        if (_YAEF_UNLIKELY(i == num_bits_block)) {
+            stats.num_cache_lines = count_cache_lines(num_bits_block - 1);
+            return stats;
+        }
+
+        // the blocks kernel
+        size_type last_read_block = num_bits_block - 1;
+        for (; i < num_bits_block; i += KERNEL_STEP_NUM_BLOCKS) {
+            const size_type step_end = std::min(i + KERNEL_STEP_NUM_BLOCKS, num_bits_block);
+            size_type step_num_ranks = 0;
+            for (size_type j = i; j < step_end; ++j) {
+                step_num_ranks += bits64::popcount(block_handler{}(bits_.blocks()[j]));
+            }
+            ++stats.num_kernel_steps;
+            if (step_num_ranks >= find.rank_distance) {
                 ++stats.num_select;
+                last_read_block = step_end - 1;
                 break;
             }
+            find.rank_distance -= step_num_ranks;
         }
+        stats.num_cache_lines = count_cache_lines(last_read_block);
         return stats;
     }
 
     template<bool BitType>
     _YAEF_ATTR_NODISCARD size_type select_impl(size_type rank) const noexcept {
+        return select_from_sample<BitType>(get_samples<BitType>().find_nearest_sample(rank));
+    }
+
+    template<bool BitType>
+    void select_batch_impl(const size_type *ranks, size_type n, size_type *out) const noexcept {
+        using sample_find_result = typename position_samples::sample_find_result;
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        const position_samples &samples = get_samples<BitType>();
+
+        sample_find_result found[SELECT_BATCH_GROUP_SIZE];
+        for (size_type first = 0; first < n; first += SELECT_BATCH_GROUP_SIZE) {
+            const size_type *group = ranks + first;
+            const size_type group_size = n - first < SELECT_BATCH_GROUP_SIZE ? n - first : SELECT_BATCH_GROUP_SIZE;
+            for (size_type i = 0; i < group_size; ++i) {
+                samples.prefetch_sample(group[i]);
+            }
+            for (size_type i = 0; i < group_size; ++i) {
+                samples.prefetch_subsample(group[i]);
+            }
+            for (size_type i = 0; i < group_size; ++i) {
+                found[i] = samples.find_nearest_sample(group[i]);
+                if (found[i].rank_distance != 0) {
+                    prefetch_read(bits_.blocks() + (found[i].position + 1) / BITS_BLOCK_WIDTH);
+                }
+            }
+            for (size_type i = 0; i < group_size; ++i) {
+                out[first + i] = select_from_sample<BitType>(found[i]);
+            }
+        }
+    }
+
+    template<bool BitType>
+    _YAEF_ATTR_NODISCARD size_type 
+    select_from_sample(typename position_samples::sample_find_result sample) const noexcept {
         using block_handler = bits64::conditional_bitwise_not<!BitType>;
         using bits_block_type = bits64::bit_view::block_type;
         
-        auto sample = get_samples<BitType>().find_nearest_sample(rank);
         if (_YAEF_UNLIKELY(sample.rank_distance == 0)) {
             return sample.position;
         }
@@ -3149,51 +6109,338 @@ private:
             }
         }
 
+        // the target is usually a few blocks away from the sample, so the next blocks are 
+        // checked inline. the rest is left to the blocks kernels, which consume a cache line 
+        // per step.
         const size_type num_bits_block = bits_.num_blocks();
-
-#ifdef __clang__
-#   pragma clang loop unroll_count(4)
-#elif defined(__GNUC__)
-#   pragma GCC unroll 4
-#endif
-        for (size_type i = bits_block_index + 1; i < num_bits_block; ++i) {
+        const size_type inline_scan_end = std::min(bits_block_index + 1 + SELECT_INLINE_SCAN_NUM_BLOCKS, 
+                                                   num_bits_block);
+        size_type i = bits_block_index + 1;
+        for (; i < inline_scan_end; ++i) {
             bits_block_type bits_block = block_handler{}(bits_.blocks()[i]);
             auto scan_res = scan_single_block(bits_block, BITS_BLOCK_WIDTH);
             bool stop = scan_res.first;
             uint32_t step = scan_res.second;
 
             result += step;
-            if (stop) { break; }
+            if (stop) { return result; }
+        }
+        if (_YAEF_UNLIKELY(i == num_bits_block)) {
+            return result;
+        }
+
+        const uint64_t *scan_blocks = bits_.blocks() + i;
+        const size_type k = sample.rank_distance - 1;
+        if _YAEF_CXX17_CONSTEXPR (BitType) {
+            return result + bits64::select_one_blocks(scan_blocks, num_bits_block - i, k);
+        } else {
+            return result + bits64::select_zero_blocks(scan_blocks, num_bits_block - i, k);
+        }
+    }
+
+public:
+    // !!!(dev-only)
+    _YAEF_ATTR_NODISCARD memory_access_stats select_one_scan_stats(size_type rank) const noexcept {
+        return select_impl_scan_stats<true>(rank);
+    }
+
+    _YAEF_ATTR_NODISCARD memory_access_stats  select_zero_scan_stats(size_type rank) const noexcept {
+        return select_impl_scan_stats<false>(rank);
+    }
+};
+
+using selectable_dense_bits = basic_selectable_dense_bits<default_sampling_policy>;
+
+// a dense bitvector with the rank counters interleaved with the bits. every 64-byte line holds
+// the number of 1s before it, the numbers of 1s before its last 5 words relative to the line 
+// (9 bits each), and 6 words of bits. a rank touches a single line and needs one popcount, a 
+// select looks up a sparse hint and then the lines between two hints. unlike 
+// `selectable_dense_bits`, the bits are copied. the allocation has room for one more line minus 
+// a word, and the lines start at its first 64-byte boundary, so each line is in one cache line 
+// whatever the alignment of the allocator.
+class interleaved_dense_bits {
+public:
+    using size_type = size_t;
+
+    static constexpr size_type LINE_NUM_WORDS        = 8;
+    static constexpr size_type LINE_ALIGNMENT        = LINE_NUM_WORDS * sizeof(uint64_t);
+    static constexpr size_type LINE_NUM_HEADER_WORDS = 2;
+    static constexpr size_type LINE_NUM_DATA_WORDS   = LINE_NUM_WORDS - LINE_NUM_HEADER_WORDS;
+    static constexpr size_type LINE_NUM_BITS         = LINE_NUM_DATA_WORDS * bits64::bit_view::BLOCK_WIDTH;
+    static constexpr uint32_t  RELATIVE_COUNT_WIDTH  = 9;
+    static constexpr size_type SELECT_HINT_RATE      = 256;
+
+public:
+    interleaved_dense_bits() = default;
+
+    template<typename AllocT>
+    interleaved_dense_bits(AllocT &alloc, bits64::bit_view bits)
+        : num_bits_(bits.size()) {
+        _YAEF_STATIC_ASSERT_NOMSG(std::is_same<typename std::allocator_traits<AllocT>::value_type, uint8_t>::value);
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        
+        // one more line than required, so that the rank of `size()` is always in a line
+        const size_type num_lines = num_bits_ / LINE_NUM_BITS + 1;
+        lines_ = allocate_packed_ints(alloc, 64, num_lines * LINE_NUM_WORDS + LINE_NUM_WORDS - 1);
+        line_offset_ = aligned_line_offset(lines_.blocks());
+
+        uint64_t *words = lines_.blocks() + line_offset_;
+        const size_type num_blocks = bits.num_blocks();
+        for (size_type i = 0; i < num_blocks; ++i) {
+            uint64_t block = bits.blocks()[i];
+            if (i == num_blocks - 1 && num_bits_ % BITS_BLOCK_WIDTH != 0) {
+                block &= bits64::make_mask_lsb1(num_bits_ % BITS_BLOCK_WIDTH);
+            }
+            words[i / LINE_NUM_DATA_WORDS * LINE_NUM_WORDS + LINE_NUM_HEADER_WORDS + i % LINE_NUM_DATA_WORDS] = block;
+        }
+
+        for (size_type l = 0; l < num_lines; ++l) {
+            uint64_t *line = words + l * LINE_NUM_WORDS;
+            uint64_t relative_counts = 0;
+            size_type relative_num_ones = 0;
+            for (size_type j = 0; j < LINE_NUM_DATA_WORDS; ++j) {
+                if (j != 0) {
+                    relative_counts |= static_cast<uint64_t>(relative_num_ones) << ((j - 1) * RELATIVE_COUNT_WIDTH);
+                }
+                relative_num_ones += bits64::popcount(line[LINE_NUM_HEADER_WORDS + j]);
+            }
+            line[0] = num_ones_;
+            line[1] = relative_counts;
+            num_ones_ += relative_num_ones;
+        }
+
+        one_hints_ = make_select_hints<true>(alloc);
+        zero_hints_ = make_select_hints<false>(alloc);
+    }
+
+    template<typename AllocT>
+    void deallocate(AllocT &alloc) {
+        deallocate_packed_ints(alloc, lines_);
+        deallocate_packed_ints(alloc, one_hints_);
+        deallocate_packed_ints(alloc, zero_hints_);
+    }
+
+    template<typename AllocT>
+    _YAEF_ATTR_NODISCARD interleaved_dense_bits duplicate(AllocT &alloc) const {
+        interleaved_dense_bits res;
+        res.num_bits_ = num_bits_;
+        res.num_ones_ = num_ones_;
+        res.lines_ = duplicate_packed_ints(alloc, lines_);
+        res.realign_lines(line_offset_);
+        res.one_hints_ = duplicate_packed_ints(alloc, one_hints_);
+        res.zero_hints_ = duplicate_packed_ints(alloc, zero_hints_);
+        return res;
+    }
+
+    _YAEF_ATTR_NODISCARD size_type size() const noexcept { return num_bits_; }
+    _YAEF_ATTR_NODISCARD size_type num_ones() const noexcept { return num_ones_; }
+    _YAEF_ATTR_NODISCARD size_type num_zeros() const noexcept { return num_bits_ - num_ones_; }
+
+    _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
+        return lines_.space_usage_in_bytes() +
+               one_hints_.space_usage_in_bytes() +
+               zero_hints_.space_usage_in_bytes();
+    }
+
+    _YAEF_ATTR_NODISCARD bool get_bit(size_type index) const noexcept {
+        _YAEF_ASSERT(index < size());
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        const size_type line_offset = index % LINE_NUM_BITS;
+        const uint64_t word = get_line(index / LINE_NUM_BITS)[LINE_NUM_HEADER_WORDS + line_offset / BITS_BLOCK_WIDTH];
+        return (word >> (line_offset % BITS_BLOCK_WIDTH)) & 1;
+    }
+
+    // return the number of 1s in [0, index)
+    _YAEF_ATTR_NODISCARD size_type rank_one(size_type index) const noexcept {
+        _YAEF_ASSERT(index <= size());
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        const uint64_t *line = get_line(index / LINE_NUM_BITS);
+        const size_type line_offset = index % LINE_NUM_BITS;
+        const size_type word_index = line_offset / BITS_BLOCK_WIDTH,
+                        word_offset = line_offset % BITS_BLOCK_WIDTH;
+
+        size_type res = line[0] + relative_count(line, word_index);
+        if (word_offset != 0) {
+            res += bits64::popcount(line[LINE_NUM_HEADER_WORDS + word_index] & bits64::make_mask_lsb1(word_offset));
+        }
+        return res;
+    }
+
+    _YAEF_ATTR_NODISCARD size_type rank_zero(size_type index) const noexcept {
+        return index - rank_one(index);
+    }
+
+    _YAEF_ATTR_NODISCARD size_type select_one(size_type rank) const noexcept {
+        _YAEF_ASSERT(rank < num_ones());
+        return select_impl<true>(rank);
+    }
+
+    _YAEF_ATTR_NODISCARD size_type select_zero(size_type rank) const noexcept {
+        _YAEF_ASSERT(rank < num_zeros());
+        return select_impl<false>(rank);
+    }
+
+    void swap(interleaved_dense_bits &other) noexcept {
+        std::swap(num_bits_, other.num_bits_);
+        std::swap(num_ones_, other.num_ones_);
+        std::swap(line_offset_, other.line_offset_);
+        lines_.swap(other.lines_);
+        one_hints_.swap(other.one_hints_);
+        zero_hints_.swap(other.zero_hints_);
+    }
+
+    _YAEF_ATTR_NODISCARD friend bool operator==(const interleaved_dense_bits &lhs, const interleaved_dense_bits &rhs) noexcept {
+        if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
+            return true;
+        }
+        return lhs.num_bits_ == rhs.num_bits_ &&
+               lhs.num_lines() == rhs.num_lines() &&
+               std::equal(lhs.get_line(0), lhs.get_line(lhs.num_lines()), rhs.get_line(0));
+    }
+
+#if __cplusplus < 202002L
+    _YAEF_ATTR_NODISCARD friend bool operator!=(const interleaved_dense_bits &lhs, const interleaved_dense_bits &rhs) noexcept {
+        return !(lhs == rhs);
+    }
+#endif
+
+    error_code serialize(serializer &ser) const {
+        if (!ser.write(num_bits_)) { return error_code::serialize_io; }
+        if (!ser.write(num_ones_)) { return error_code::serialize_io; }
+        if (!ser.write(line_offset_)) { return error_code::serialize_io; }
+        _YAEF_RETURN_ERR_IF_FAIL(lines_.serialize(ser));
+        _YAEF_RETURN_ERR_IF_FAIL(one_hints_.serialize(ser));
+        _YAEF_RETURN_ERR_IF_FAIL(zero_hints_.serialize(ser));
+        return error_code::success;
+    }
+
+    template<typename AllocT>
+    error_code deserialize(AllocT &alloc, deserializer &deser) {
+        if (!deser.read(num_bits_)) { return error_code::deserialize_io; }
+        if (!deser.read(num_ones_)) { return error_code::deserialize_io; }
+        size_type line_offset = 0;
+        if (!deser.read(line_offset)) { return error_code::deserialize_io; }
+        if (line_offset >= LINE_NUM_WORDS) { return error_code::deserialize_invalid_format; }
+        _YAEF_RETURN_ERR_IF_FAIL(lines_.deserialize(alloc, deser));
+        if (lines_.size() % LINE_NUM_WORDS != LINE_NUM_WORDS - 1) { return error_code::deserialize_invalid_format; }
+        // the lines were written at the boundary of the old allocation
+        realign_lines(line_offset);
+        _YAEF_RETURN_ERR_IF_FAIL(one_hints_.deserialize(alloc, deser));
+        _YAEF_RETURN_ERR_IF_FAIL(zero_hints_.deserialize(alloc, deser));
+        return error_code::success;
+    }
+
+    // !!!(dev-only)
+    _YAEF_ATTR_NODISCARD const uint64_t *lines_data() const noexcept { return get_line(0); }
+
+private:
+    size_type               num_bits_ = 0;
+    size_type               num_ones_ = 0;
+    // the number of words before the first 64-byte boundary of `lines_`
+    size_type               line_offset_ = 0;
+    bits64::packed_int_view lines_;
+    // the i-th hint is the line of the (i * SELECT_HINT_RATE)-th 1 or 0
+    bits64::packed_int_view one_hints_;
+    bits64::packed_int_view zero_hints_;
+
+    _YAEF_ATTR_NODISCARD size_type num_lines() const noexcept { return lines_.size() / LINE_NUM_WORDS; }
+
+    _YAEF_ATTR_NODISCARD const uint64_t *get_line(size_type line_index) const noexcept {
+        return lines_.blocks() + line_offset_ + line_index * LINE_NUM_WORDS;
+    }
+
+    _YAEF_ATTR_NODISCARD static size_type aligned_line_offset(const uint64_t *words) noexcept {
+        const size_type addr = static_cast<size_type>(reinterpret_cast<uintptr_t>(words));
+        _YAEF_ASSERT(addr % sizeof(uint64_t) == 0);
+        return (LINE_ALIGNMENT - addr % LINE_ALIGNMENT) % LINE_ALIGNMENT / sizeof(uint64_t);
+    }
+
+    // move the lines, which start `old_offset` words into `lines_`, to its 64-byte boundary. 
+    // used after `lines_` is copied or read into a new allocation.
+    void realign_lines(size_type old_offset) noexcept {
+        line_offset_ = aligned_line_offset(lines_.blocks());
+        if (line_offset_ != old_offset) {
+            std::memmove(lines_.blocks() + line_offset_, lines_.blocks() + old_offset, 
+                         num_lines() * LINE_NUM_WORDS * sizeof(uint64_t));
+        }
+    }
+
+    // the number of 1s before the `word_index`-th word within the line
+    _YAEF_ATTR_NODISCARD static size_type relative_count(const uint64_t *line, size_type word_index) noexcept {
+        if (word_index == 0) {
+            return 0;
+        }
+        return (line[1] >> ((word_index - 1) * RELATIVE_COUNT_WIDTH)) & bits64::make_mask_lsb1(RELATIVE_COUNT_WIDTH);
+    }
+
+    template<bool BitType>
+    _YAEF_ATTR_NODISCARD static size_type relative_rank(const uint64_t *line, size_type word_index) noexcept {
+        const size_type num_ones_before = relative_count(line, word_index);
+        if _YAEF_CXX17_CONSTEXPR (BitType) {
+            return num_ones_before;
+        } else {
+            return word_index * bits64::bit_view::BLOCK_WIDTH - num_ones_before;
+        }
+    }
+
+    // the number of 1s or 0s before the line, the 0s are only counted within `size()`
+    template<bool BitType>
+    _YAEF_ATTR_NODISCARD size_type rank_before_line(size_type line_index) const noexcept {
+        const size_type num_ones_before = get_line(line_index)[0];
+        if _YAEF_CXX17_CONSTEXPR (BitType) {
+            return num_ones_before;
+        } else {
+            return std::min(line_index * LINE_NUM_BITS, num_bits_) - num_ones_before;
+        }
+    }
+
+    template<bool BitType, typename AllocT>
+    _YAEF_ATTR_NODISCARD bits64::packed_int_view make_select_hints(AllocT &alloc) const {
+        const size_type num_ranks = BitType ? num_ones() : num_zeros();
+        const size_type num_hints = bits64::idiv_ceil(num_ranks, SELECT_HINT_RATE);
+        auto hints = allocate_packed_ints(alloc, std::max<uint32_t>(1, bits64::bit_width(num_lines())), num_hints);
+        for (size_type l = 0, next_hint = 0; next_hint < num_hints; ++l) {
+            const size_type next_rank = l + 1 < num_lines() ? rank_before_line<BitType>(l + 1) : num_ranks;
+            for (; next_hint < num_hints && next_hint * SELECT_HINT_RATE < next_rank; ++next_hint) {
+                hints.set_value(next_hint, l);
+            }
         }
-        return result;
+        return hints;
     }
 
-    _YAEF_ATTR_NODISCARD memory_access_stats select_one_scan_stats(size_type rank) const noexcept {
-        return select_impl_scan_stats<true>(rank);
-    }
+    template<bool BitType>
+    _YAEF_ATTR_NODISCARD size_type select_impl(size_type rank) const noexcept {
+        using block_handler = bits64::conditional_bitwise_not<!BitType>;
+        constexpr size_type BITS_BLOCK_WIDTH = bits64::bit_view::BLOCK_WIDTH;
+        const bits64::packed_int_view &hints = BitType ? one_hints_ : zero_hints_;
+
+        // the answer is in the lines [lo, hi], find the last one with no more than `rank` 
+        // 1s or 0s before it
+        const size_type hint_index = rank / SELECT_HINT_RATE;
+        size_type lo = hints.get_value(hint_index);
+        size_type hi = hint_index + 1 < hints.size() ? hints.get_value(hint_index + 1) : num_lines() - 1;
+        while (lo < hi) {
+            const size_type mid = lo + (hi - lo + 1) / 2;
+            if (rank_before_line<BitType>(mid) <= rank) {
+                lo = mid;
+            } else {
+                hi = mid - 1;
+            }
+        }
 
-    _YAEF_ATTR_NODISCARD memory_access_stats  select_zero_scan_stats(size_type rank) const noexcept {
-        return select_impl_scan_stats<false>(rank);
+        // the relative counts locate the word without any popcount
+        const uint64_t *line = get_line(lo);
+        const size_type remaining = rank - rank_before_line<BitType>(lo);
+        size_type word_index = 0;
+        while (word_index + 1 < LINE_NUM_DATA_WORDS && relative_rank<BitType>(line, word_index + 1) <= remaining) {
+            ++word_index;
+        }
+        const uint64_t word = block_handler{}(line[LINE_NUM_HEADER_WORDS + word_index]);
+        return lo * LINE_NUM_BITS + word_index * BITS_BLOCK_WIDTH + 
+               bits64::select_one(word, static_cast<uint32_t>(remaining - relative_rank<BitType>(line, word_index)));
     }
 };
 
-_YAEF_ATTR_NODISCARD inline bool 
-operator==(const selectable_dense_bits &lhs, const selectable_dense_bits &rhs) noexcept {
-    if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
-        return true;
-    }
-    return lhs.bits_ == rhs.bits_ &&
-           lhs.zero_samples_ == rhs.zero_samples_ &&
-           lhs.one_samples_ == rhs.one_samples_;
-}
-
-#if __cplusplus < 202002L
-_YAEF_ATTR_NODISCARD inline bool 
-operator!=(const selectable_dense_bits &lhs, const selectable_dense_bits &rhs) noexcept {
-    return !(lhs == rhs);
-}
-#endif
-
 template<typename T>
 class eliasfano_bidirectional_iterator {
 public:
@@ -3249,6 +6496,13 @@ public:
         return old;
     }
 
+    // move forward by k elements without visiting each of them
+    eliasfano_bidirectional_iterator &advance_by(bits64::packed_int_view::size_type k) noexcept {
+        index_ += k;
+        high_bits_cursor_.advance_by(k);
+        return *this;
+    }
+
     _YAEF_ATTR_NODISCARD bits64::packed_int_view::size_type to_index() const noexcept {
         return index_;
     }
@@ -3285,6 +6539,110 @@ _YAEF_ATTR_NODISCARD inline bool operator!=(const eliasfano_bidirectional_iterat
 
 } // namespace details
 
+// the most capable tier supported by both the build and the running cpu
+_YAEF_ATTR_NODISCARD inline simd_tier detected_simd_tier() noexcept {
+    return details::bits64::detect_simd_tier();
+}
+
+// the tier currently used by the block kernels
+_YAEF_ATTR_NODISCARD inline simd_tier active_simd_tier() noexcept {
+    return details::bits64::blocks_kernels().tier;
+}
+
+// pin the block kernels to `tier` (clamped to `detected_simd_tier()`) and return the
+// tier actually taken. mainly for testing, it should not race with running queries.
+inline simd_tier force_simd_tier(simd_tier tier) noexcept {
+    tier = std::min(tier, detected_simd_tier());
+    details::bits64::active_blocks_kernel_table().store(
+        &details::bits64::get_blocks_kernel_table(tier), std::memory_order_relaxed);
+    return tier;
+}
+
+inline simd_tier reset_simd_tier() noexcept {
+    return force_simd_tier(details::bits64::initial_simd_tier());
+}
+
+// whether `select_one` uses PDEP, which is turned off on cpus with a microcoded PDEP
+_YAEF_ATTR_NODISCARD inline bool pdep_select_enabled() noexcept {
+    return details::bits64::pdep_select_switch<>::enabled.load(std::memory_order_relaxed);
+}
+
+// enabling only takes effect if the build has BMI2 and the cpu supports it. mainly 
+// for testing and benchmarking, the queries running meanwhile may use either way.
+inline bool force_pdep_select(bool enabled) noexcept {
+#if _YAEF_INTRINSICS_HAVE_BMI2
+    enabled = enabled && details::get_cpu_features().bmi2;
+#else
+    enabled = false;
+#endif
+    details::bits64::pdep_select_switch<>::enabled.store(enabled, std::memory_order_relaxed);
+    return enabled;
+}
+
+// call `f(assumed_width_t<width>{})`, so that generic callers get code specialized for 
+// every width in [1, 64] with a single switch outside of their loops.
+template<typename F>
+inline auto visit_assumed_width(uint32_t width, F &&f) -> decltype(f(assumed_width_t<1>{})) {
+    _YAEF_ASSERT(width > 0 && width <= 64);
+#define _YAEF_ASSUMED_WIDTH_CASE(w) case (w): return f(assumed_width_t<(w)>{});
+#define _YAEF_ASSUMED_WIDTH_CASES_8(base) \
+    _YAEF_ASSUMED_WIDTH_CASE(base + 1) _YAEF_ASSUMED_WIDTH_CASE(base + 2) \
+    _YAEF_ASSUMED_WIDTH_CASE(base + 3) _YAEF_ASSUMED_WIDTH_CASE(base + 4) \
+    _YAEF_ASSUMED_WIDTH_CASE(base + 5) _YAEF_ASSUMED_WIDTH_CASE(base + 6) \
+    _YAEF_ASSUMED_WIDTH_CASE(base + 7) _YAEF_ASSUMED_WIDTH_CASE(base + 8)
+    switch (width) {
+        _YAEF_ASSUMED_WIDTH_CASES_8(0)  _YAEF_ASSUMED_WIDTH_CASES_8(8)
+        _YAEF_ASSUMED_WIDTH_CASES_8(16) _YAEF_ASSUMED_WIDTH_CASES_8(24)
+        _YAEF_ASSUMED_WIDTH_CASES_8(32) _YAEF_ASSUMED_WIDTH_CASES_8(40)
+        _YAEF_ASSUMED_WIDTH_CASES_8(48) _YAEF_ASSUMED_WIDTH_CASES_8(56)
+        default: break;
+    }
+#undef _YAEF_ASSUMED_WIDTH_CASES_8
+#undef _YAEF_ASSUMED_WIDTH_CASE
+    return f(assumed_width_t<64>{});
+}
+
+// a predicate on unsigned integers, which is always a closed range [min, max]. 
+// an empty range (min > max) matches nothing.
+struct int_predicate {
+    uint64_t min;
+    uint64_t max;
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate none() noexcept { 
+        return int_predicate{1, 0}; 
+    }
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate less(uint64_t value) noexcept {
+        return value == 0 ? none() : int_predicate{0, value - 1};
+    }
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate less_equal(uint64_t value) noexcept {
+        return int_predicate{0, value};
+    }
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate equal(uint64_t value) noexcept {
+        return int_predicate{value, value};
+    }
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate greater(uint64_t value) noexcept {
+        return value == std::numeric_limits<uint64_t>::max() ? 
+               none() : int_predicate{value + 1, std::numeric_limits<uint64_t>::max()};
+    }
+
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate greater_equal(uint64_t value) noexcept {
+        return int_predicate{value, std::numeric_limits<uint64_t>::max()};
+    }
+
+    // [lo, hi)
+    _YAEF_ATTR_NODISCARD static constexpr int_predicate between(uint64_t lo, uint64_t hi) noexcept {
+        return hi <= lo ? none() : int_predicate{lo, hi - 1};
+    }
+
+    _YAEF_ATTR_NODISCARD constexpr bool operator()(uint64_t value) const noexcept {
+        return min <= value && value <= max;
+    }
+};
+
 struct from_sorted_t { };
 
 #if __cplusplus < 201703L
@@ -3293,10 +6651,21 @@ static constexpr from_sorted_t from_sorted{};
 inline constexpr from_sorted_t from_sorted{};
 #endif
 
+// widen the elements of a `packed_int_buffer` when a new value does not fit
+struct auto_widen_t { };
+
+#if __cplusplus < 201703L
+static constexpr auto_widen_t auto_widen{};
+#else
+inline constexpr auto_widen_t auto_widen{};
+#endif
+
 #if _YAEF_USE_CXX_CONCEPTS
-template<std::integral T, typename AllocT = details::aligned_allocator<uint8_t, 32>>
+template<std::integral T, typename AllocT = details::aligned_allocator<uint8_t, 32>, 
+         typename SamplingPolicy = default_sampling_policy>
 #else
-template<typename T, typename AllocT = details::aligned_allocator<uint8_t, 32>>
+template<typename T, typename AllocT = details::aligned_allocator<uint8_t, 32>, 
+         typename SamplingPolicy = default_sampling_policy>
 #endif
 class eliasfano_list {
 #if !_YAEF_USE_CXX_CONCEPTS
@@ -3310,7 +6679,7 @@ class eliasfano_list {
 
     friend struct details::serialize_friend_access;
 
-    using high_bits_type      = details::selectable_dense_bits;
+    using high_bits_type      = details::basic_selectable_dense_bits<SamplingPolicy>;
     using low_bits_type       = details::bits64::packed_int_view;
     using alloc_traits        = std::allocator_traits<AllocT>;
     using unsigned_value_type = uint64_t;
@@ -3443,6 +6812,7 @@ public:
     _YAEF_ATTR_NODISCARD bool empty() const noexcept { return size() == 0; }
     _YAEF_ATTR_NODISCARD allocator_type get_allocator() const noexcept { return get_alloc(); }
     _YAEF_ATTR_NODISCARD bool has_duplicates() const { return has_duplicates_; }
+    _YAEF_ATTR_NODISCARD uint32_t low_width() const noexcept { return get_low_bits().width(); }
 
     _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_integral)
     _YAEF_ATTR_NODISCARD static size_type 
@@ -3483,11 +6853,15 @@ public:
     _YAEF_ATTR_NODISCARD const_iterator cbegin() const noexcept { return begin(); }
     _YAEF_ATTR_NODISCARD const_iterator cend() const noexcept { return end(); }
 
+    // a list loaded with `deserialize_flags::lazy_select_samples` builds its select samples in the 
+    // first `iter`, `at` or search. they are allocated with the list's allocator, whose failure 
+    // is thrown from `iter` and `at`.
     _YAEF_ATTR_NODISCARD const_iterator iter(size_type index) const _YAEF_MAYBE_NOEXCEPT {
         _YAEF_ASSERT(index < size());
         if (_YAEF_UNLIKELY(index >= size())) {
             _YAEF_THROW(std::out_of_range{"eliasfano_list::iter: index is out of range"});
         }
+        ensure_select_samples();
         return make_iter(high_bits_.select_one(index), index);
     }
 
@@ -3523,20 +6897,38 @@ public:
         return max_;
     }
 
+    // may build the select samples of a lazily loaded list, see `iter`
     _YAEF_ATTR_NODISCARD value_type at(size_type index) const _YAEF_MAYBE_NOEXCEPT {
         _YAEF_ASSERT(index < size());
         if (_YAEF_UNLIKELY(index >= size())) {
             _YAEF_THROW(std::out_of_range{"eliasfano_list::at: index is out of range"});
         }
+        ensure_select_samples();
         unsigned_value_type h = high_bits_.select_one(index) - index - 1;
         unsigned_value_type l = get_low_bits().get_value(index);
         return to_actual_value(merge_bits(h, l));
     }
 
+    // `at` with the width of the low bits known at compile time, `W` must be equal to `low_width()`
+    template<uint32_t W>
+    _YAEF_ATTR_NODISCARD value_type at(size_type index, assumed_width_t<W> w) const _YAEF_MAYBE_NOEXCEPT {
+        constexpr uint32_t VALUE_WIDTH = sizeof(unsigned_value_type) * CHAR_BIT;
+        _YAEF_ASSERT(index < size());
+        if (_YAEF_UNLIKELY(index >= size())) {
+            _YAEF_THROW(std::out_of_range{"eliasfano_list::at: index is out of range"});
+        }
+        ensure_select_samples();
+        unsigned_value_type h = high_bits_.select_one(index) - index - 1;
+        unsigned_value_type l = get_low_bits().get_value(index, w);
+        return to_actual_value(W >= VALUE_WIDTH ? l : (h << (W % VALUE_WIDTH)) | l);
+    }
+
     _YAEF_ATTR_NODISCARD value_type operator[](size_type index) const _YAEF_MAYBE_NOEXCEPT {
         return at(index);
     }
 
+    // the searches are noexcept, a failed allocation of the samples of a lazily loaded list (see 
+    // `iter`) terminates. call `at` or `iter` once before searching to handle it instead.
     _YAEF_ATTR_NODISCARD const_iterator lower_bound(value_type target) const noexcept {
         return search_iter_impl(target, [](value_type elem, value_type t) -> bool {
             return elem < t;
@@ -3567,27 +6959,27 @@ public:
     }
 
     eliasfano_list &assign(std::initializer_list<value_type> initlist) {
-        eliasfano_list<value_type> new_list(initlist);
+        eliasfano_list new_list(initlist);
         swap(new_list);
         return *this;
     }
 
     eliasfano_list &assign(from_sorted_t, std::initializer_list<value_type> initlist) {
-        eliasfano_list<value_type> new_list(from_sorted, initlist);
+        eliasfano_list new_list(from_sorted, initlist);
         swap(new_list);
         return *this;
     }
 
     _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_integral)
     eliasfano_list &assign(RandomAccessIterT first, SentIterT last) {
-        eliasfano_list<value_type> new_list(first, last);
+        eliasfano_list new_list(first, last);
         swap(new_list);
         return *this;
     }
 
     _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_integral)
     eliasfano_list &assign(from_sorted_t, RandomAccessIterT first, SentIterT last) {
-        eliasfano_list<value_type> new_list(from_sorted, first, last);
+        eliasfano_list new_list(from_sorted, first, last);
         swap(new_list);
         return *this;
     }
@@ -3606,14 +6998,14 @@ public:
         std::swap(has_duplicates_, other.has_duplicates_);
     }
 
-    template<typename U, typename AllocU>
-    friend bool operator==(const eliasfano_list<U, AllocU> &lhs, 
-                           const eliasfano_list<U, AllocU> &rhs);
+    template<typename U, typename AllocU, typename SamplingPolicyU>
+    friend bool operator==(const eliasfano_list<U, AllocU, SamplingPolicyU> &lhs, 
+                           const eliasfano_list<U, AllocU, SamplingPolicyU> &rhs);
 
 #if __cplusplus < 202002L
-    template<typename U, typename AllocU>
-    friend bool operator!=(const eliasfano_list<U, AllocU> &lhs, 
-                           const eliasfano_list<U, AllocU> &rhs);
+    template<typename U, typename AllocU, typename SamplingPolicyU>
+    friend bool operator!=(const eliasfano_list<U, AllocU, SamplingPolicyU> &lhs, 
+                           const eliasfano_list<U, AllocU, SamplingPolicyU> &rhs);
 #endif
 
 protected:
@@ -3628,6 +7020,8 @@ protected:
 
     error_code do_deserialize(details::deserializer &deser) {
         _YAEF_RETURN_ERR_IF_FAIL(high_bits_.deserialize(get_alloc(), deser));
+        // the list may have been written with fewer sides than this policy selects
+        high_bits_.build_select_samples(get_alloc(), SamplingPolicy::SIDES);
         _YAEF_RETURN_ERR_IF_FAIL(get_low_bits().deserialize(get_alloc(), deser));
         if (!deser.read(min_)) { return error_code::deserialize_io; }
         if (!deser.read(max_)) { return error_code::deserialize_io; }
@@ -3737,6 +7131,14 @@ private:
         return low_bits_with_alloc_.alloc();
     }
 
+    // lazily loaded lists build their select samples on the first select
+    void ensure_select_samples() const {
+        if (_YAEF_UNLIKELY(high_bits_.needs_select_samples())) {
+            allocator_type alloc = get_alloc();
+            high_bits_.ensure_select_samples(alloc);
+        }
+    }
+
     _YAEF_ATTR_NODISCARD unsigned_value_type split_high_bits(unsigned_value_type v) const noexcept {
         return v >> get_low_bits().width();
     }
@@ -3772,6 +7174,8 @@ private:
     template<typename CmpElemWithTargetT>
     _YAEF_ATTR_NODISCARD search_result
     search_impl(value_type target, CmpElemWithTargetT cmp) const noexcept {
+        static_assert(has_select_side(SamplingPolicy::SIDES, select_sides::zeros),
+                      "searching an eliasfano_list requires a sampling policy that samples the 0s");
         if (_YAEF_UNLIKELY(!cmp(min(), target))) {
             return search_result{0, 0};
         }
@@ -3779,6 +7183,7 @@ private:
             return search_result{0, size()};
         }
 
+        ensure_select_samples();
         const size_type num_zeros = high_bits_.size() - size();
         const unsigned_value_type t = to_stored_value(target);
         const unsigned_value_type h = split_high_bits(t);
@@ -3787,16 +7192,38 @@ private:
         const size_type end = h + 1 == num_zeros ? size() : high_bits_.select_zero(h + 1) - h - 1;
         size_type len = end - start;
 
-        size_type result = end;
+        size_type result;
 
+        // a long bucket is narrowed down by the binary search first, then the rest is scanned 
+        // linearly by the find kernels, which test a whole group of low bits at once and touch 
+        // the memory in order. a very short range is still faster with the branchless search.
+        constexpr size_type LINEAR_SEARCH_MIN_LEN = details::bits64::PACKED_GROUP_SIZE;
+        constexpr size_type LINEAR_SEARCH_MAX_LEN = 64;
         auto &low_bits = get_low_bits();
         size_type base = start;
-        while (len > 0) {
+        auto binary_search_step = [&]() {
             size_type half = len / 2;
             base += (cmp(low_bits.get_value(base + half), l)) * (len - half);
             len = half;
+        };
+        while (len > LINEAR_SEARCH_MAX_LEN) {
+            binary_search_step();
+        }
+
+        if (len < LINEAR_SEARCH_MIN_LEN) {
+            while (len > 0) {
+                binary_search_step();
+            }
+            result = base;
+        } else if (!cmp(l, l)) {
+            // `cmp` is either `<` or `<=`, so the first low bits failing it are the first 
+            // ones not less than `l` or `l + 1` respectively
+            result = low_bits.find_not_less(base, base + len, l);
+        } else if (l != std::numeric_limits<unsigned_value_type>::max()) {
+            result = low_bits.find_not_less(base, base + len, l + 1);
+        } else {
+            result = base + len;
         }
-        result = base;
         const size_type num_skipped_zeros = h + 1;
         return search_result{num_skipped_zeros, result};
     }
@@ -3816,9 +7243,9 @@ private:
     }
 };
 
-template<typename T, typename AllocT>
+template<typename T, typename AllocT, typename SamplingPolicy>
 _YAEF_ATTR_NODISCARD inline bool 
-operator==(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT> &rhs) {
+operator==(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
         return true;
     }
@@ -3826,9 +7253,9 @@ operator==(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT>
 }
 
 #if __cplusplus >= 202002L
-template<typename T, typename AllocT>
+template<typename T, typename AllocT, typename SamplingPolicy>
 _YAEF_ATTR_NODISCARD inline std::strong_ordering
-operator<=>(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT> &rhs) {
+operator<=>(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
         return std::strong_ordering::equivalent;
     }
@@ -3850,15 +7277,15 @@ operator<=>(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT
     }
 }
 #else
-template<typename T, typename AllocT>
-_YAEF_ATTR_NODISCARD inline bool operator!=(const eliasfano_list<T, AllocT> &lhs, 
-                                            const eliasfano_list<T, AllocT> &rhs) {
+template<typename T, typename AllocT, typename SamplingPolicy>
+_YAEF_ATTR_NODISCARD inline bool operator!=(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, 
+                                            const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     return !(lhs == rhs);
 }
 
-template<typename T, typename AllocT>
-_YAEF_ATTR_NODISCARD inline bool operator<(const eliasfano_list<T, AllocT> &lhs, 
-                                           const eliasfano_list<T, AllocT> &rhs) {
+template<typename T, typename AllocT, typename SamplingPolicy>
+_YAEF_ATTR_NODISCARD inline bool operator<(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, 
+                                           const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     if (_YAEF_UNLIKELY(std::addressof(lhs) == std::addressof(rhs))) {
         return false;
     }
@@ -3873,21 +7300,21 @@ _YAEF_ATTR_NODISCARD inline bool operator<(const eliasfano_list<T, AllocT> &lhs,
     return lhs.size() < rhs.size();
 }
 
-template<typename T, typename AllocT>
+template<typename T, typename AllocT, typename SamplingPolicy>
 _YAEF_ATTR_NODISCARD inline bool
-operator>(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT> &rhs) {
+operator>(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     return rhs < lhs;
 }
 
-template<typename T, typename AllocT>
+template<typename T, typename AllocT, typename SamplingPolicy>
 _YAEF_ATTR_NODISCARD inline bool
-operator<=(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT> &rhs) {
+operator<=(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     return !(rhs < lhs);
 }
 
-template<typename T, typename AllocT>
+template<typename T, typename AllocT, typename SamplingPolicy>
 _YAEF_ATTR_NODISCARD inline bool
-operator>=(const eliasfano_list<T, AllocT> &lhs, const eliasfano_list<T, AllocT> &rhs) {
+operator>=(const eliasfano_list<T, AllocT, SamplingPolicy> &lhs, const eliasfano_list<T, AllocT, SamplingPolicy> &rhs) {
     return !(lhs < rhs);
 }
 #endif
@@ -4391,37 +7818,9 @@ public:
     eliasfano_sparse_bitmap(const uint64_t *blocks, size_type num_bits,
                             const allocator_type &alloc = allocator_type{})
         : num_bits_(num_bits) {
-        constexpr size_type BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
-        const size_type num_full_blocks = num_bits / BLOCK_WIDTH,
-                        num_rem_bits = num_bits % BLOCK_WIDTH;
-        const size_type num_blocks = num_full_blocks + (num_rem_bits > 0 ? 1 : 0);
-
-        size_t num_indexed_bits = 0;
-
-        for (size_t i = 0; i < num_full_blocks; ++i) {
-            uint64_t block = blocks[i];
-            if _YAEF_CXX17_CONSTEXPR (!INDEXED_BIT_TYPE) {
-                block = ~block;
-            }
-            num_indexed_bits += details::bits64::popcount(block);
-        }
-        
-        // handle last block if need
-        if (num_rem_bits != 0) {
-            uint64_t block = blocks[num_full_blocks];
-            if _YAEF_CXX17_CONSTEXPR (!INDEXED_BIT_TYPE) {
-                block = ~block;
-            }
-            block = details::bits64::extract_first_bits(block, num_rem_bits);
-            num_indexed_bits += details::bits64::popcount(block);
-        }
-
-        auto indices = details::make_unique_array<size_type>(num_indexed_bits);
-        size_type indice_writer = 0;
-
-        details::bits64::bitmap_multiblocks_foreach_impl<INDEXED_BIT_TYPE>(blocks, num_blocks, [&](size_type index) {
-            indices[indice_writer++] = index;
-        });
+        const size_type num_indexed_bits = count_indexed_bits(blocks, num_bits);
+        auto indices = details::make_unique_array<uint64_t>(num_indexed_bits);
+        decode_indexed_bits(blocks, num_bits, indices.get(), num_indexed_bits);
         pos_list_ = eliasfano_list<size_type, allocator_type>(indices.get(), indices.get() + num_indexed_bits, alloc);
     }
 
@@ -4429,18 +7828,20 @@ public:
     eliasfano_sparse_bitmap(const uint64_t *blocks, size_type num_bits, 
                             size_type num_indexed_bits, const allocator_type &alloc = allocator_type{})
         : num_bits_(num_bits) {
-        const size_type num_blocks = details::bits64::idiv_ceil(num_bits, sizeof(uint64_t) * CHAR_BIT);
-        auto indices = details::make_unique_array<size_type>(num_indexed_bits);
-        size_type indice_writer = 0;
-
-        details::bits64::bitmap_multiblocks_foreach_impl<INDEXED_BIT_TYPE>(blocks, num_blocks, [&](size_type index) {
-            if (indice_writer > num_indexed_bits) {
-                _YAEF_THROW(std::out_of_range{
-                    "eliasfano_sparse_bitmap::eliasfano_sparse_bitmap: "
-                    "the number of indexed bits exceeds the parameter `num_indexed_bits`."});
-            }
-            indices[indice_writer++] = index;
-        });
+        // the indices are decoded in bulk, so the count is checked before writing any of them
+        const size_type count = count_indexed_bits(blocks, num_bits);
+        if (count > num_indexed_bits) {
+            _YAEF_THROW(std::out_of_range{
+                "eliasfano_sparse_bitmap::eliasfano_sparse_bitmap: "
+                "the number of indexed bits exceeds the parameter `num_indexed_bits`."});
+        }
+        if (count < num_indexed_bits) {
+            _YAEF_THROW(std::invalid_argument{
+                "eliasfano_sparse_bitmap::eliasfano_sparse_bitmap: "
+                "the number of indexed bits is less than the parameter `num_indexed_bits`."});
+        }
+        auto indices = details::make_unique_array<uint64_t>(num_indexed_bits);
+        decode_indexed_bits(blocks, num_bits, indices.get(), num_indexed_bits);
         pos_list_ = eliasfano_list<size_type, allocator_type>{indices.get(), indices.get() + num_indexed_bits, alloc};
     }
 
@@ -4594,6 +7995,45 @@ private:
     base_list_type pos_list_;
     size_type      num_bits_;
 
+    // the padding bits of the last block are not indexed, whatever their values
+    _YAEF_ATTR_NODISCARD static uint64_t last_indexed_block(const uint64_t *blocks, size_type num_bits) noexcept {
+        constexpr size_type BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+        const uint64_t block = blocks[num_bits / BLOCK_WIDTH];
+        const uint64_t mask = details::bits64::make_mask_lsb1(static_cast<uint32_t>(num_bits % BLOCK_WIDTH));
+        return INDEXED_BIT_TYPE ? block & mask : block | ~mask;
+    }
+
+    _YAEF_ATTR_NODISCARD static size_type count_indexed_bits(const uint64_t *blocks, size_type num_bits) noexcept {
+        constexpr size_type BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+        const size_type num_full_blocks = num_bits / BLOCK_WIDTH;
+        size_type num_ones = details::bits64::popcount_range(blocks, num_full_blocks);
+        if (num_bits % BLOCK_WIDTH != 0) {
+            num_ones += details::bits64::popcount(last_indexed_block(blocks, num_bits));
+        }
+        const size_type num_padded_bits = details::bits64::idiv_ceil(num_bits, BLOCK_WIDTH) * BLOCK_WIDTH;
+        return INDEXED_BIT_TYPE ? num_ones : num_padded_bits - num_ones;
+    }
+
+    // write the indices of the indexed bits to `out`, which has room for exactly `num_indexed_bits` 
+    // of them (see `count_indexed_bits`), returns their number
+    static size_type decode_indexed_bits(const uint64_t *blocks, size_type num_bits, 
+                                         uint64_t *out, size_type num_indexed_bits) {
+        constexpr size_type BLOCK_WIDTH = sizeof(uint64_t) * CHAR_BIT;
+        const size_type num_full_blocks = num_bits / BLOCK_WIDTH;
+        size_type num_decoded = INDEXED_BIT_TYPE ? 
+            details::bits64::decode_onebits(blocks, num_full_blocks, out, num_indexed_bits) :
+            details::bits64::decode_zerobits(blocks, num_full_blocks, out, num_indexed_bits);
+        if (num_bits % BLOCK_WIDTH != 0) {
+            const uint64_t last_block = last_indexed_block(blocks, num_bits);
+            const uint64_t index_offset = num_full_blocks * BLOCK_WIDTH;
+            const size_type out_capacity = num_indexed_bits - num_decoded;
+            num_decoded += INDEXED_BIT_TYPE ? 
+                details::bits64::decode_onebits(&last_block, 1, out + num_decoded, out_capacity, index_offset) :
+                details::bits64::decode_zerobits(&last_block, 1, out + num_decoded, out_capacity, index_offset);
+        }
+        return num_decoded;
+    }
+
     class index_related_impl {
     public:
         index_related_impl(const eliasfano_sparse_bitmap *parent) noexcept
@@ -4676,6 +8116,8 @@ class bit_buffer {
     using view_type       = details::bits64::bit_view;
     using inner_type      = details::value_with_allocator_pair<view_type, AllocT>;
 
+    template<typename AllocU>
+    friend class bit_buffer;
     friend struct details::serialize_friend_access;
 public:
     using size_type       = typename view_type::size_type;
@@ -4800,6 +8242,45 @@ public:
         get_view().clear_all_bits();
     }
 
+    _YAEF_ATTR_NODISCARD size_type find_next_one(size_type pos) const { return get_view().find_next_one(pos); }
+    _YAEF_ATTR_NODISCARD size_type find_next_zero(size_type pos) const { return get_view().find_next_zero(pos); }
+    _YAEF_ATTR_NODISCARD size_type find_prev_one(size_type pos) const { return get_view().find_prev_one(pos); }
+    _YAEF_ATTR_NODISCARD size_type find_prev_zero(size_type pos) const { return get_view().find_prev_zero(pos); }
+
+    // this = this op rhs in place, returns the number of 1s of the result if `count_ones`, otherwise 0
+    template<typename AllocU>
+    size_type combine_with(bitwise_op op, const bit_buffer<AllocU> &rhs, bool count_ones = false) {
+        return get_view().combine_with(op, rhs.get_view(), count_ones);
+    }
+
+    // this = lhs op rhs, the buffer is reallocated if its size differs from the operands
+    template<typename AllocU, typename AllocV>
+    size_type assign_combined(bitwise_op op, const bit_buffer<AllocU> &lhs, const bit_buffer<AllocV> &rhs, 
+                              bool count_ones = false) {
+        _YAEF_ASSERT(lhs.size() == rhs.size());
+        prepare_combined(lhs.size());
+        return get_view().assign_combined(op, lhs.get_view(), rhs.get_view(), count_ones);
+    }
+
+    // this = srcs[0] op ... op srcs[num_srcs - 1] in a single pass over the memory
+    template<typename AllocU>
+    size_type assign_combined(bitwise_op op, const bit_buffer<AllocU> *const *srcs, size_type num_srcs, 
+                              bool count_ones = false) {
+        _YAEF_ASSERT(num_srcs != 0);
+        std::vector<const view_type *> views(num_srcs);
+        for (size_type i = 0; i < num_srcs; ++i) {
+            views[i] = &srcs[i]->get_view();
+        }
+        prepare_combined(srcs[0]->size());
+        return get_view().assign_combined(op, views.data(), num_srcs, count_ones);
+    }
+
+    template<typename AllocU>
+    size_type assign_combined(bitwise_op op, std::initializer_list<const bit_buffer<AllocU> *> srcs, 
+                              bool count_ones = false) {
+        return assign_combined(op, srcs.begin(), srcs.size(), count_ones);
+    }
+
     void reset() {
         details::deallocate_bits(get_alloc(), get_view());
         get_view() = view_type{};
@@ -4840,6 +8321,14 @@ private:
     _YAEF_ATTR_NODISCARD const view_type &get_view() const { return inner_.value(); }
     _YAEF_ATTR_NODISCARD view_type &get_view() { return inner_.value(); }
 
+    // the old bits are overwritten, so they are not copied when the size changes. an operand 
+    // may be this buffer itself, in which case the size already matches.
+    void prepare_combined(size_type new_size) {
+        if (new_size == size()) { return; }
+        details::deallocate_bits(get_alloc(), get_view());
+        get_view() = new_size != 0 ? details::allocate_bits(get_alloc(), new_size) : view_type{};
+    }
+
     error_code do_serialize(details::serializer &ser) const {
         return get_view().serialize(ser);
     }
@@ -4882,12 +8371,14 @@ public:
     packed_int_buffer() = default;
 
     packed_int_buffer(const packed_int_buffer &other) {
-        get_view() = details::duplicate_packed_ints(get_alloc(), other.get_view());
+        reset_storage(details::duplicate_packed_ints(get_alloc(), other.get_view()));
     }
 
     packed_int_buffer(packed_int_buffer &&other) noexcept {
         get_view() = other.get_view();
+        num_storage_blocks_ = other.num_storage_blocks_;
         other.get_view() = view_type{};
+        other.num_storage_blocks_ = 0;
     }
 
     packed_int_buffer(uint32_t width, size_type size) {
@@ -4895,7 +8386,7 @@ public:
             _YAEF_THROW(std::runtime_error{
                 "packed_int_buffer::packed_int_buffer: the width of packed_int_buffer should be between 0 and 64."});
         }
-        get_view() = details::allocate_packed_ints(get_alloc(), width, size);
+        reset_storage(details::allocate_packed_ints(get_alloc(), width, size));
     }
 
     _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_unsigned)
@@ -4903,19 +8394,15 @@ public:
         auto max_val = details::find_max_value(first, last);
         uint32_t width = std::max<uint32_t>(1, details::bits64::bit_width(max_val));
         size_type size = details::iter_distance(first, last);
-        get_view() = details::allocate_packed_ints(get_alloc(), width, size);
-        for (size_type i = 0; i < size; ++i) {
-            set_value(i, *first++);
-        }
+        reset_storage(details::allocate_packed_ints(get_alloc(), width, size));
+        details::fill_packed_ints(get_view(), first, [](value_type val) { return val; });
     }
 
     _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_unsigned)
     packed_int_buffer(RandomAccessIterT first, SentIterT last, uint32_t width) {
         size_type size = details::iter_distance(first, last);
-        get_view() = details::allocate_packed_ints(get_alloc(), width, size);
-        for (size_type i = 0; i < size; ++i) {
-            set_value(i, *first++);
-        }
+        reset_storage(details::allocate_packed_ints(get_alloc(), width, size));
+        details::fill_packed_ints(get_view(), first, [](value_type val) { return val; });
     }
 
     packed_int_buffer(std::initializer_list<value_type> initlist)
@@ -4925,27 +8412,45 @@ public:
         : packed_int_buffer(initlist.begin(), initlist.end(), width) { }
 
     ~packed_int_buffer() {
-        details::deallocate_packed_ints(get_alloc(), get_view());
+        deallocate_storage();
     }
 
     packed_int_buffer &operator=(const packed_int_buffer &other) {
-        get_view() = details::duplicate_packed_ints(get_alloc(), other.get_view());
+        if (this != &other) {
+            reset_storage(details::duplicate_packed_ints(get_alloc(), other.get_view()));
+        }
         return *this;
     }
 
     packed_int_buffer &operator=(packed_int_buffer &&other) noexcept {
-        get_view() = other.get_view();
-        other.get_view() = view_type{};
+        if (this != &other) {
+            deallocate_storage();
+            get_view() = other.get_view();
+            num_storage_blocks_ = other.num_storage_blocks_;
+            other.get_view() = view_type{};
+            other.num_storage_blocks_ = 0;
+        }
         return *this;
     }
 
-    _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept { return get_view().space_usage_in_bytes(); }
+    // counts the reserved blocks, not only the ones holding values
+    _YAEF_ATTR_NODISCARD size_type space_usage_in_bytes() const noexcept {
+        return sizeof(*this) + num_storage_blocks_ * sizeof(block_type);
+    }
     _YAEF_ATTR_NODISCARD size_type size() const noexcept { return get_view().size(); }
     _YAEF_ATTR_NODISCARD bool empty() const noexcept { return size() == 0; }
     _YAEF_ATTR_NODISCARD uint32_t width() const noexcept { return get_view().width(); }
     _YAEF_ATTR_NODISCARD value_type limit_min() const { return get_view().limit_min(); }
     _YAEF_ATTR_NODISCARD value_type limit_max() const { return get_view().limit_max(); }
 
+    // the number of values of the current width that fit without reallocation
+    _YAEF_ATTR_NODISCARD size_type capacity() const noexcept {
+        if (_YAEF_UNLIKELY(width() == 0)) { 
+            return std::numeric_limits<size_type>::max(); 
+        }
+        return num_storage_blocks_ * view_type::BLOCK_WIDTH / width();
+    }
+
     _YAEF_ATTR_NODISCARD const block_type *block_data() const noexcept { return get_view().blocks(); }
     _YAEF_ATTR_NODISCARD block_type *block_data() noexcept { return get_view().blocks(); }
     _YAEF_ATTR_NODISCARD size_type num_blocks() const noexcept { return get_view().num_blocks(); }
@@ -4956,13 +8461,10 @@ public:
         uint32_t width = std::max<uint32_t>(1, details::bits64::bit_width(max_val));
         size_type size = details::iter_distance(first, last);
         if (this->size() != size || this->width() != width) {
-            details::deallocate_packed_ints(get_alloc(), get_view());
-            get_view() = details::allocate_packed_ints(get_alloc(), width, size);
+            reset_storage(details::allocate_packed_ints(get_alloc(), width, size));
         }
 
-        for (size_type i = 0; i < size; ++i) {
-            set_value(i, *first++);
-        }
+        details::fill_packed_ints(get_view(), first, [](value_type val) { return val; });
         return *this;
     }
 
@@ -4970,12 +8472,9 @@ public:
     packed_int_buffer &assign(RandomAccessIterT first, SentIterT last, uint32_t width) {
         size_type size = details::iter_distance(first, last);
         if (this->size() != size || this->width() != width) {
-            details::deallocate_packed_ints(get_alloc(), get_view());
-            get_view() = details::allocate_packed_ints(get_alloc(), width, size);
-        }
-        for (size_type i = 0; i < size; ++i) {
-            set_value(i, *first++);
+            reset_storage(details::allocate_packed_ints(get_alloc(), width, size));
         }
+        details::fill_packed_ints(get_view(), first, [](value_type val) { return val; });
         return *this;
     }
 
@@ -4991,10 +8490,50 @@ public:
         return get_view().get_value(index); 
     }
 
+    void get_values(size_type first, size_type last, value_type *out) const noexcept {
+        get_view().get_values(first, last, out);
+    }
+
+    _YAEF_ATTR_NODISCARD size_type find_not_less(size_type first, size_type last, value_type target) const noexcept {
+        return get_view().find_not_less(first, last, target);
+    }
+
+    value_type get_prefix_sums(size_type first, size_type last, value_type *out, value_type init = 0) const noexcept {
+        return get_view().get_prefix_sums(first, last, out, init);
+    }
+
+    _YAEF_ATTR_NODISCARD value_type find_max_value(size_type first, size_type last) const noexcept {
+        return get_view().find_max_value(first, last);
+    }
+
+    _YAEF_ATTR_NODISCARD value_type find_max_value() const noexcept { return find_max_value(0, size()); }
+
+    void delta_encode(size_type first, size_type last) noexcept {
+        get_view().delta_encode(first, last);
+    }
+
+    void delta_encode() noexcept { delta_encode(0, size()); }
+
+    void delta_decode(size_type first, size_type last) noexcept {
+        get_view().delta_decode(first, last);
+    }
+
+    void delta_decode() noexcept { delta_decode(0, size()); }
+
     void set_value(size_type index, value_type value) noexcept { 
         get_view().set_value(index, value); 
     }
 
+    template<uint32_t W>
+    _YAEF_ATTR_NODISCARD value_type get_value(size_type index, assumed_width_t<W> w) const noexcept { 
+        return get_view().get_value(index, w); 
+    }
+
+    template<uint32_t W>
+    void set_value(size_type index, value_type value, assumed_width_t<W> w) noexcept { 
+        get_view().set_value(index, value, w); 
+    }
+
     void prefetch_for_read(size_type first, size_type last) const {
         get_view().prefetch_for_read(first, last);
     }
@@ -5003,6 +8542,26 @@ public:
         get_view().prefetch_for_write(first, last);
     }
 
+    // evaluate `pred` on the values in [first, last) without unpacking them, the result of 
+    // the i-th value is written to `out[i - first]`. `out` is resized if its size is not 
+    // `last - first`.
+    template<typename AllocU>
+    void scan(size_type first, size_type last, int_predicate pred, bit_buffer<AllocU> &out) const {
+        _YAEF_ASSERT(first <= last);
+        _YAEF_ASSERT(last <= size());
+        if (out.size() != last - first) {
+            out = bit_buffer<AllocU>(last - first);
+        }
+        details::bits64::bit_view out_view{out.block_data(), out.size()};
+        get_view().scan_between(first, last, pred.min, pred.max, out_view);
+    }
+
+    _YAEF_ATTR_NODISCARD bit_buffer<AllocT> scan(int_predicate pred) const {
+        bit_buffer<AllocT> out(size());
+        scan(0, size(), pred, out);
+        return out;
+    }
+
     _YAEF_ATTR_NODISCARD value_type operator[](size_type index) const noexcept {
         return get_view().get_value(index);
     }
@@ -5020,29 +8579,92 @@ public:
     }
 
     void reset() {
-        details::deallocate_packed_ints(get_alloc(), get_view());
-        get_view() = view_type{};
+        reset_storage(view_type{});
     }
 
+    // the new values are zero. shrinking keeps the storage, like `std::vector`.
     void resize(size_t new_size) {
         _YAEF_ASSERT(width() != 0);
 
         if (_YAEF_UNLIKELY(new_size == size())) { return; }
-        if (_YAEF_UNLIKELY(new_size == 0)) { 
-            reset(); 
-            return;
+        if (new_size < size()) {
+            get_view().to_bit_view().clear_all_bits(new_size * width(), (size() - new_size) * width());
+        } else {
+            reserve(new_size);
         }
+        get_view() = view_type{width(), get_view().blocks(), new_size};
+    }
 
-        auto new_vec = details::allocate_packed_ints(get_alloc(), width(), new_size);
-        for (size_t i = 0; i < size(); ++i) {
-            new_vec.set_value(i, get_value(i));
+    void reserve(size_type new_capacity) {
+        const size_type required_blocks = details::bits64::idiv_ceil(new_capacity * width(), view_type::BLOCK_WIDTH);
+        if (required_blocks > num_storage_blocks_) {
+            reallocate_storage(width(), required_blocks);
         }
-        details::deallocate_packed_ints(get_alloc(), get_view());
-        get_view() = new_vec;
+    }
+
+    void shrink_to_fit() {
+        if (num_storage_blocks_ > get_view().num_blocks()) {
+            reallocate_storage(width(), get_view().num_blocks());
+        }
+    }
+
+    // repack the values in place to the smallest width that holds them. the values only move 
+    // towards the front, so repacking them from the front never overwrites the unread ones. the 
+    // storage is kept as capacity, `shrink_to_fit` releases it. returns the number of bytes no 
+    // longer used by the values.
+    size_type shrink_to_fit_width() {
+        if (_YAEF_UNLIKELY(width() == 0 || empty())) { return 0; }
+
+        const uint32_t new_width = std::max<uint32_t>(1, details::bits64::bit_width(find_max_value()));
+        if (new_width == width()) { return 0; }
+
+        constexpr size_type STAGE_SIZE = 256;
+        view_type old_view = get_view();
+        view_type new_view{new_width, get_view().blocks(), size()};
+        value_type staged[STAGE_SIZE];
+        for (size_type first = 0; first < size(); first += STAGE_SIZE) {
+            const size_type last = first + std::min(STAGE_SIZE, size() - first);
+            old_view.get_values(first, last, staged);
+            new_view.set_values(first, last, staged);
+        }
+        old_view.to_bit_view().clear_all_bits(size() * new_width, size() * (width() - new_width));
+        get_view() = new_view;
+        return (old_view.num_blocks() - new_view.num_blocks()) * sizeof(block_type);
+    }
+
+    // the value is truncated to `width()` bits, like `set_value`
+    void push_back(value_type value) {
+        _YAEF_ASSERT(width() != 0);
+        const size_type new_size = size() + 1;
+        if (_YAEF_UNLIKELY(new_size * width() > num_storage_blocks_ * view_type::BLOCK_WIDTH)) {
+            grow_storage(width(), new_size);
+        }
+        get_view() = view_type{width(), get_view().blocks(), new_size};
+        get_view().set_value(new_size - 1, value);
+    }
+
+    void push_back(auto_widen_t, value_type value) {
+        if (_YAEF_UNLIKELY(value > limit_max() || width() == 0)) {
+            widen(std::max<uint32_t>(1, details::bits64::bit_width(value)), size() + 1);
+        }
+        push_back(value);
+    }
+
+    _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_unsigned)
+    void append(RandomAccessIterT first, SentIterT last) {
+        _YAEF_ASSERT(width() != 0);
+        append_impl(first, last, false);
+    }
+
+    // widen the elements at most once per staged chunk of values
+    _YAEF_REQUIRES_RANDOM_ACCESS_ITER(RandomAccessIterT, SentIterT, std::is_unsigned)
+    void append(auto_widen_t, RandomAccessIterT first, SentIterT last) {
+        append_impl(first, last, true);
     }
 
     void swap(packed_int_buffer &other) noexcept {
         get_view().swap(other.get_view());
+        std::swap(num_storage_blocks_, other.num_storage_blocks_);
     }
 
     template<typename AllocU, typename AllocV>
@@ -5055,32 +8677,126 @@ public:
 
 private:
     inner_type inner_;
+    // the blocks are allocated for more values than `size()` by `reserve` and `push_back`, 
+    // the bits beyond `size()` are always zero.
+    size_type  num_storage_blocks_ = 0;
 
     _YAEF_ATTR_NODISCARD const allocator_type &get_alloc() const { return inner_.alloc(); }
     _YAEF_ATTR_NODISCARD allocator_type &get_alloc() { return inner_.alloc(); }
     _YAEF_ATTR_NODISCARD const view_type &get_view() const { return inner_.value(); }
     _YAEF_ATTR_NODISCARD view_type &get_view() { return inner_.value(); }
 
+    // the storage is allocated and deallocated as a packed int view of whole blocks
+    void deallocate_storage() noexcept {
+        view_type storage{view_type::BLOCK_WIDTH, get_view().blocks(), num_storage_blocks_};
+        details::deallocate_packed_ints(get_alloc(), storage);
+    }
+
+    void reset_storage(view_type new_view) noexcept {
+        deallocate_storage();
+        get_view() = new_view;
+        num_storage_blocks_ = new_view.num_blocks();
+    }
+
+    // move the values to a new storage of `new_num_blocks` blocks with the width `new_width`
+    void reallocate_storage(uint32_t new_width, size_type new_num_blocks) {
+        view_type storage = details::allocate_packed_ints(get_alloc(), view_type::BLOCK_WIDTH, new_num_blocks);
+        view_type new_view{new_width, storage.blocks(), size()};
+        if (new_width == width()) {
+            std::copy_n(get_view().blocks(), get_view().num_blocks(), new_view.blocks());
+        } else {
+            constexpr size_type STAGE_SIZE = 256;
+            value_type staged[STAGE_SIZE];
+            for (size_type i = 0; i < size(); i += STAGE_SIZE) {
+                const size_type num = std::min(STAGE_SIZE, size() - i);
+                get_view().get_values(i, i + num, staged);
+                new_view.set_values(i, i + num, staged);
+            }
+        }
+        deallocate_storage();
+        get_view() = new_view;
+        num_storage_blocks_ = new_num_blocks;
+    }
+
+    // the capacity grows geometrically, so that pushing a value is amortized O(1)
+    void grow_storage(uint32_t new_width, size_type min_capacity) {
+        const size_type required_blocks = details::bits64::idiv_ceil(min_capacity * new_width, view_type::BLOCK_WIDTH);
+        reallocate_storage(new_width, std::max<size_type>(required_blocks, num_storage_blocks_ * 2));
+    }
+
+    // repack the values to a larger width, with room for at least `min_capacity` values. the 
+    // values only move towards the end, so when the storage is large enough, repacking them 
+    // from the back never overwrites the unread ones.
+    void widen(uint32_t new_width, size_type min_capacity) {
+        _YAEF_ASSERT(new_width > width() && new_width <= 64);
+        const size_type required_blocks = details::bits64::idiv_ceil(min_capacity * new_width, view_type::BLOCK_WIDTH);
+        if (required_blocks > num_storage_blocks_) {
+            grow_storage(new_width, min_capacity);
+            return;
+        }
+
+        constexpr size_type STAGE_SIZE = 256;
+        const view_type old_view = get_view();
+        view_type new_view{new_width, get_view().blocks(), size()};
+        value_type staged[STAGE_SIZE];
+        for (size_type last = size(); last > 0;) {
+            const size_type first = last - std::min(STAGE_SIZE, last);
+            old_view.get_values(first, last, staged);
+            new_view.set_values(first, last, staged);
+            last = first;
+        }
+        get_view() = new_view;
+    }
+
+    template<typename RandomAccessIterT, typename SentIterT>
+    void append_impl(RandomAccessIterT first, SentIterT last, bool widen_if_needed) {
+        constexpr size_type STAGE_SIZE = 256;
+        const size_type old_size = size(), num = details::iter_distance(first, last);
+        if (old_size + num > capacity()) {
+            grow_storage(width(), old_size + num);
+        }
+
+        value_type staged[STAGE_SIZE];
+        for (size_type i = 0; i < num; i += STAGE_SIZE) {
+            const size_type chunk_size = std::min(STAGE_SIZE, num - i);
+            value_type chunk_max = 0;
+            for (size_type j = 0; j < chunk_size; ++j, ++first) {
+                staged[j] = *first;
+                chunk_max = std::max(chunk_max, staged[j]);
+            }
+            if (widen_if_needed && (chunk_max > limit_max() || width() == 0)) {
+                widen(std::max<uint32_t>(1, details::bits64::bit_width(chunk_max)), old_size + num);
+            }
+            get_view() = view_type{width(), get_view().blocks(), old_size + i + chunk_size};
+            get_view().set_values(old_size + i, old_size + i + chunk_size, staged);
+        }
+    }
+
     error_code do_serialize(details::serializer &ser) const {
         return get_view().serialize(ser);
     }
 
     error_code do_deserialize(details::deserializer &deser) {
-        return get_view().deserialize(get_alloc(), deser);        
+        view_type new_view;
+        error_code err = new_view.deserialize(get_alloc(), deser);
+        if (err == error_code::success) {
+            reset_storage(new_view);
+        }
+        return err;
     }
 };
 
 template<typename AllocT, typename AllocU>
 _YAEF_ATTR_NODISCARD inline bool operator==(const packed_int_buffer<AllocT> &lhs, 
                                             const packed_int_buffer<AllocU> &rhs) {
-    return lhs.inner_ == rhs.inner_;
+    return lhs.get_view() == rhs.get_view();
 }
 
 #if __cplusplus < 202002L
 template<typename AllocT, typename AllocU>
 _YAEF_ATTR_NODISCARD inline bool operator!=(const packed_int_buffer<AllocT> &lhs, 
                                             const packed_int_buffer<AllocU> &rhs) {
-    return lhs.inner_ != rhs.inner_;
+    return lhs.get_view() != rhs.get_view();
 }
 #endif
 
@@ -6047,6 +9763,13 @@ public:
         bit_view bv(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(data)), bit_view::dont_care_size);
         const uint32_t width = ext_meta;
 
+        // the partitions are padded by `UNPACK_GROUP_READ_BYTES`, so every group may be read 
+        // by the find kernels, see `hybrid_list::get_data_bytes`
+        if (width <= details::bits64::PACKED_GROUP_MAX_WIDTH) {
+            *res_out = details::bits64::find_ints_not_less(data, width, 0, details::DEFAULT_HYBRID_PARTITION_SIZE, target);
+            return;
+        }
+
         for (size_t i = 0, bit_offset = 0; i < details::DEFAULT_HYBRID_PARTITION_SIZE; ++i, bit_offset += width) {
            if (bv.get_bits(bit_offset, width) >= target) {
                 *res_out = i;
@@ -6111,6 +9834,19 @@ public:
         bit_view bv(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(data)), bit_view::dont_care_size);
         const uint32_t width = ext_meta;
 
+        // decode the leading gaps in one pass, see `fixed::index_of_lower_bound` for the padding
+        if (width <= details::bits64::PACKED_GROUP_MAX_WIDTH) {
+            if (offset == 0) {
+                *res_out = 0;
+                return;
+            }
+            uint64_t sums[details::DEFAULT_HYBRID_PARTITION_SIZE];
+            const size_t num_groups = details::bits64::idiv_ceil(offset, details::bits64::PACKED_GROUP_SIZE);
+            details::bits64::unpack_prefix_sum_ints(data, width, num_groups, 0, sums);
+            *res_out = sums[offset - 1];
+            return;
+        }
+
         uint64_t res = 0;
         for (size_t i = 0, bit_offset = 0; i < offset; ++i, bit_offset += width) {
             uint64_t gap = bv.get_bits(bit_offset, width);
@@ -6124,6 +9860,26 @@ public:
         bit_view bv(reinterpret_cast<uint64_t *>(const_cast<uint8_t *>(data)), bit_view::dont_care_size);
         const uint32_t width = ext_meta;
 
+        // the gaps are summed a few groups at a time, so that an early match skips the rest
+        if (width <= details::bits64::PACKED_GROUP_MAX_WIDTH) {
+            constexpr size_t CHUNK_SIZE = 4 * details::bits64::PACKED_GROUP_SIZE;
+            constexpr size_t NUM_GAPS = details::DEFAULT_HYBRID_PARTITION_SIZE - 1;
+            uint64_t sums[CHUNK_SIZE];
+            uint64_t carry = 0;
+            for (size_t first = 0; first < NUM_GAPS; first += CHUNK_SIZE) {
+                carry = details::bits64::unpack_prefix_sum_ints(data + first / details::bits64::PACKED_GROUP_SIZE * width, 
+                                                                width, CHUNK_SIZE / details::bits64::PACKED_GROUP_SIZE, 
+                                                                carry, sums);
+                const size_t num = std::min(CHUNK_SIZE, NUM_GAPS - first);
+                if (sums[num - 1] >= target) {
+                    *res_out = std::lower_bound(sums, sums + num, target) - sums + first + 1;
+                    return;
+                }
+            }
+            *res_out = details::DEFAULT_HYBRID_PARTITION_SIZE;
+            return;
+        }
+
         uint64_t val = 0;
         for (size_t i = 0, bit_offset = 0; i < details::DEFAULT_HYBRID_PARTITION_SIZE - 1; ++i, bit_offset += width) {
             uint64_t gap = bv.get_bits(bit_offset, width);
@@ -6477,11 +10233,7 @@ public:
         const uint64_t *upper_addr = reinterpret_cast<const uint64_t *>(
             data + details::DEFAULT_HYBRID_PARTITION_SIZE * lower_width / CHAR_BIT);
 
-#if _YAEF_INTRINSICS_HAVE_AVX512
-        uint64_t hi = details::bits64::select_one_blocks_512_avx512(upper_addr, MAX_NUM_BLOCKS, offset) - offset;
-#else
-        uint64_t hi = details::bits64::select_one_blocks(upper_addr, MAX_NUM_BLOCKS, offset) - offset;
-#endif
+        uint64_t hi = details::bits64::select_one_blocks_512(upper_addr, MAX_NUM_BLOCKS, offset) - offset;
         *res_out = (hi << lower_width) | lo;
     }
 
@@ -6502,13 +10254,8 @@ public:
         const uint64_t *upper_addr = reinterpret_cast<const uint64_t *>(
             data + details::DEFAULT_HYBRID_PARTITION_SIZE * lower_width / CHAR_BIT);
 
-#if _YAEF_INTRINSICS_HAVE_AVX512
-        size_t start = details::bits64::select_zero_blocks_512_avx512(upper_addr, MAX_NUM_BLOCKS, hi - 1) - hi + 1;
-        size_t end = details::bits64::select_zero_blocks_512_avx512(upper_addr, MAX_NUM_BLOCKS, hi) - hi;
-#else
-        size_t start = details::bits64::select_zero_blocks(upper_addr, MAX_NUM_BLOCKS, hi - 1) - hi + 1;
-        size_t end = details::bits64::select_zero_blocks(upper_addr, MAX_NUM_BLOCKS, hi) - hi;
-#endif
+        size_t start = details::bits64::select_zero_blocks_512(upper_addr, MAX_NUM_BLOCKS, hi - 1) - hi + 1;
+        size_t end = details::bits64::select_zero_blocks_512(upper_addr, MAX_NUM_BLOCKS, hi) - hi;
         start = std::min(start, details::DEFAULT_HYBRID_PARTITION_SIZE);
         end = std::min(end, details::DEFAULT_HYBRID_PARTITION_SIZE);
         size_t len = end - start;
@@ -6569,7 +10316,8 @@ public:
             details::bits64::align_to<8>(PARTITION_DESC_BYTES * num_partitions));
         std::uninitialized_copy_n(other.partition_descs_, PARTITION_DESC_BYTES * num_partitions, partition_descs_);
         data_ = alloc_traits::allocate(get_alloc(), get_data_bytes());
-        std::uninitialized_copy_n(other.data_, get_data_bytes(), data_);
+        std::uninitialized_copy_n(other.data_, get_meta().data_bytes, data_);
+        clear_data_padding();
     }
 
     hybrid_list(hybrid_list &&other) noexcept
@@ -6859,8 +10607,14 @@ private:
     _YAEF_ATTR_NODISCARD allocator_type &get_alloc() { return meta_with_alloc_.alloc(); }
     _YAEF_ATTR_NODISCARD const allocator_type &get_alloc() const { return meta_with_alloc_.alloc(); }
 
+    // the buffer is padded so that the group kernels may read a whole group from any partition
     _YAEF_ATTR_NODISCARD size_type get_data_bytes() const noexcept {
-        return details::bits64::align_to<32>(get_meta().data_bytes);
+        return details::bits64::align_to<32>(get_meta().data_bytes + details::bits64::UNPACK_GROUP_READ_BYTES);
+    }
+
+    // the padding is never written by the encoders, but the kernels read it
+    void clear_data_padding() noexcept {
+        std::uninitialized_fill_n(data_ + get_meta().data_bytes, get_data_bytes() - get_meta().data_bytes, 0);
     }
 
     _YAEF_ATTR_NODISCARD value_type to_actual_value(unsigned_value_type v) const noexcept {
@@ -6901,6 +10655,7 @@ private:
         if (!deser.read_bytes(data_, get_meta().data_bytes)) {
             return error_code::deserialize_io;
         }
+        clear_data_padding();
         return error_code::success;
     }
 
@@ -6963,6 +10718,7 @@ private:
         size_type required_bytes = details::bits64::idiv_ceil(required_bits, CHAR_BIT);
         meta.data_bytes = required_bytes;
         data_ = alloc_traits::allocate(get_alloc(), get_data_bytes());
+        clear_data_padding();
 
         for (size_type i = 0; i < num_partitions; ++i) {
             const uint64_t partition_desc = 
@@ -6976,19 +10732,21 @@ private:
 };
 
 template<typename T>
-inline error_code serialize_to_buf(const T &x, uint8_t *buf, size_t buf_size) {
-    auto ser = details::serializer{details::make_unique_obj<details::membuf_writer_context>(buf, buf_size)};
+inline error_code serialize_to_buf(const T &x, uint8_t *buf, size_t buf_size, 
+                                   serialize_flags flags = serialize_flags::none) {
+    auto ser = details::serializer{details::make_unique_obj<details::membuf_writer_context>(buf, buf_size), flags};
     return details::serialize_friend_access::serialize(x, ser);
 }
 
 template<typename T>
-inline error_code serialize_to_file(const T &x, FILE *file) {
-    auto ser = details::serializer{details::make_unique_obj<details::cfile_writer_context>(file)};
+inline error_code serialize_to_file(const T &x, FILE *file, serialize_flags flags = serialize_flags::none) {
+    auto ser = details::serializer{details::make_unique_obj<details::cfile_writer_context>(file), flags};
     return details::serialize_friend_access::serialize(x, ser);
 }
 
 template<typename T>
-inline error_code serialize_to_file(const T &x, const char *path, bool overwrite) {
+inline error_code serialize_to_file(const T &x, const char *path, bool overwrite, 
+                                    serialize_flags flags = serialize_flags::none) {
     FILE *file = nullptr;
     if (overwrite) {
         file = ::fopen(path, "wb");
@@ -6998,32 +10756,34 @@ inline error_code serialize_to_file(const T &x, const char *path, bool overwrite
     if (file == nullptr) {
         return error_code::serialize_io;
     }
-    error_code ec = serialize_to_file(x, file);
+    error_code ec = serialize_to_file(x, file, flags);
     ::fclose(file);
     return ec;
 }
 
 template<typename T>
-inline error_code serialize_to_file(const T &x, const std::string &path, bool overwrite) {
-    return serialize_to_file(x, path.c_str(), overwrite);
+inline error_code serialize_to_file(const T &x, const std::string &path, bool overwrite, 
+                                    serialize_flags flags = serialize_flags::none) {
+    return serialize_to_file(x, path.c_str(), overwrite, flags);
 }
 
 template<typename T>
-inline error_code serialize_to_stream(const T &x, std::ostream &stream) {
-    auto ser = details::serializer{details::make_unique_obj<details::ostream_writer_context>(stream)};
+inline error_code serialize_to_stream(const T &x, std::ostream &stream, serialize_flags flags = serialize_flags::none) {
+    auto ser = details::serializer{details::make_unique_obj<details::ostream_writer_context>(stream), flags};
     return details::serialize_friend_access::serialize(x, ser);
 }
 
 #if _YAEF_USE_STL_SPAN
 template<typename T>
-inline error_code serialize_to_buf(const T &x, std::span<uint8_t> buf) {
-    return serialize_to_buf(x, buf.data(), buf.size());
+inline error_code serialize_to_buf(const T &x, std::span<uint8_t> buf, serialize_flags flags = serialize_flags::none) {
+    return serialize_to_buf(x, buf.data(), buf.size(), flags);
 }
 #endif
 
 #if _YAEF_USE_STL_FILESYSTEM
 template<typename T>
-inline error_code serialize_to_file(const T &x, const std::filesystem::path &path, bool overwrite) {
+inline error_code serialize_to_file(const T &x, const std::filesystem::path &path, bool overwrite, 
+                                    serialize_flags flags = serialize_flags::none) {
     auto open_flags = std::ios::out | std::ios::binary;
     if (!overwrite) {
         open_flags |= std::ios::app;
@@ -7032,55 +10792,58 @@ inline error_code serialize_to_file(const T &x, const std::filesystem::path &pat
     if (out.fail()) {
         return error_code::serialize_io;
     }
-    return serialize_to_stream(x, out);
+    return serialize_to_stream(x, out, flags);
 }
 #endif
 
 template<typename T>
-inline error_code deserialize_from_buf(T &x, const uint8_t *buf, size_t buf_size) {
-    auto deser = details::deserializer{details::make_unique_obj<details::membuf_reader_context>(buf, buf_size)};
+inline error_code deserialize_from_buf(T &x, const uint8_t *buf, size_t buf_size, 
+                                       deserialize_flags flags = deserialize_flags::none) {
+    auto deser = details::deserializer{details::make_unique_obj<details::membuf_reader_context>(buf, buf_size), flags};
     return details::serialize_friend_access::deserialize(x, deser);
 }
 
 template<typename T>
-inline error_code deserialize_from_file(T &x, FILE *file) {
-    auto deser = details::deserializer{details::make_unique_obj<details::cfile_reader_context>(file)};
+inline error_code deserialize_from_file(T &x, FILE *file, deserialize_flags flags = deserialize_flags::none) {
+    auto deser = details::deserializer{details::make_unique_obj<details::cfile_reader_context>(file), flags};
     return details::serialize_friend_access::deserialize(x, deser);
 }
 
 template<typename T>
-inline error_code deserialize_from_file(T &x, const char *path) {
+inline error_code deserialize_from_file(T &x, const char *path, deserialize_flags flags = deserialize_flags::none) {
     FILE *file = ::fopen(path, "rb");
     if (file == nullptr) {
         return error_code::deserialize_io;
     }
-    error_code ec = deserialize_from_file(x, file);
+    error_code ec = deserialize_from_file(x, file, flags);
     ::fclose(file);
     return ec;
 }
 
 template<typename T>
-inline error_code deserialize_from_stream(T &x, std::istream &stream) {
-    auto deser = details::deserializer{details::make_unique_obj<details::istream_reader_context>(stream)};
+inline error_code deserialize_from_stream(T &x, std::istream &stream, deserialize_flags flags = deserialize_flags::none) {
+    auto deser = details::deserializer{details::make_unique_obj<details::istream_reader_context>(stream), flags};
     return details::serialize_friend_access::deserialize(x, deser);
 }
 
 #if _YAEF_USE_STL_SPAN
 template<typename T>
-inline error_code deserialize_from_buf(const T &x, std::span<const uint8_t> buf) {
-    return deserialize_from_buf(x, buf.data(), buf.size());
+inline error_code deserialize_from_buf(const T &x, std::span<const uint8_t> buf, 
+                                       deserialize_flags flags = deserialize_flags::none) {
+    return deserialize_from_buf(x, buf.data(), buf.size(), flags);
 }
 #endif
 
 #if _YAEF_USE_STL_FILESYSTEM
 template<typename T>
-inline error_code deserialize_from_file(const T &x, const std::filesystem::path &path) {
+inline error_code deserialize_from_file(const T &x, const std::filesystem::path &path, 
+                                        deserialize_flags flags = deserialize_flags::none) {
     auto open_flags = std::ios::in | std::ios::binary;
     std::ifstream in(path, open_flags);
     if (in.fail()) {
         return error_code::deserialize_io;
     }
-    return deserialize_from_stream(x, in);
+    return deserialize_from_stream(x, in, flags);
 }
 #endif
 
@@ -7240,14 +11003,21 @@ decode_eliasfano(OutputIterT out_first, size_t num_elems, uint32_t low_width,
 
     details::bits64::packed_int_view low_bits_view{low_width, const_cast<uint64_t *>(low_bits), num_low_blocks};
 
+    // the positions are decoded a few blocks at a time into a buffer that fits all of their 1s
+    constexpr size_t NUM_CHUNK_BLOCKS = 4;
+    uint64_t positions[NUM_CHUNK_BLOCKS * 64];
     size_t index = 0;
-    details::bits64::bitmap_foreach_onebit(high_bits, num_high_blocks, [&](size_t pos) {
-        uint64_t high = pos - index;
-        uint64_t low = low_bits_view.get_value(index);
-        uint64_t val = (high << low_width) | low;
-        *out_first++ = val;
-        ++index;
-    });
+    for (size_t first = 0; first < num_high_blocks; first += NUM_CHUNK_BLOCKS) {
+        const size_t num_positions = details::bits64::decode_onebits(
+            high_bits + first, std::min(NUM_CHUNK_BLOCKS, num_high_blocks - first), 
+            positions, NUM_CHUNK_BLOCKS * 64, first * 64);
+        for (size_t i = 0; i < num_positions; ++i, ++index) {
+            uint64_t high = positions[i] - index;
+            uint64_t low = low_bits_view.get_value(index);
+            uint64_t val = (high << low_width) | low;
+            *out_first++ = val;
+        }
+    }
 
     decode_result res;
     return res;
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "yaef/yaef.hpp"
+
+#include "utils/bit_generator.hpp"
+#include "common.hpp"
+
+namespace bits64 = yaef::details::bits64;
+using yaef::details::selectable_dense_bits;
+using yaef::details::aligned_allocator;
+using clock_type = std::chrono::steady_clock;
+using f64nanos = std::chrono::duration<double, std::nano>;
+
+void benchmark_select_in_word(const std::vector<uint64_t> &words, const std::vector<uint32_t> &ranks) {
+  const size_t num = words.size();
+
+  auto bench_start = clock_type::now();
+  for (size_t i = 0; i < num; ++i) {
+    uint32_t index = bits64::select_one(words[i], ranks[i]);
+    dont_optimize(index);
+  }
+  auto bench_end = clock_type::now();
+  auto bench_nanos = std::chrono::duration_cast<f64nanos>(bench_end - bench_start);
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "select_one(word)    : " << bench_nanos.count() / num << "ns/op\n";
+}
+
+void benchmark_select_in_bits(const selectable_dense_bits &bits, const std::vector<size_t> &rand_indices) {
+  const size_t num = rand_indices.size();
+
+  auto bench_start = clock_type::now();
+  for (size_t i = 0; i < num; ++i) {
+    size_t index = bits.select_one(rand_indices[i]);
+    dont_optimize(index);
+  }
+  auto bench_end = clock_type::now();
+  auto bench_nanos = std::chrono::duration_cast<f64nanos>(bench_end - bench_start);
+
+  std::cout << std::fixed << std::setprecision(3)
+            << "select_one(bits)    : " << bench_nanos.count() / num << "ns/op\n";
+}
+
+int main() {
+  constexpr size_t NUM_WORDS = 1 << 20;
+  constexpr size_t NUM_BITS = 5000000;
+  constexpr double ONE_DENSITY = 0.5;
+
+  yaef::test_utils::uniform_int_generator<uint64_t> wordgen{1, UINT64_MAX};
+  std::vector<uint64_t> words = wordgen.make_list(NUM_WORDS);
+  std::vector<uint32_t> ranks(NUM_WORDS);
+  std::mt19937_64 rng{yaef::test_utils::make_random_seed()};
+  for (size_t i = 0; i < NUM_WORDS; ++i) {
+    ranks[i] = static_cast<uint32_t>(rng() % bits64::popcount(words[i]));
+  }
+
+  aligned_allocator<uint8_t, 64> alloc;
+  yaef::test_utils::bit_generator bitgen;
+  yaef::test_utils::uniform_int_generator<size_t> intgen;
+  auto bitgen_param = yaef::test_utils::bit_generator::param::by_one_density(NUM_BITS, ONE_DENSITY);
+  auto raw_bits = bitgen.make_bits(bitgen_param);
+  selectable_dense_bits bits(alloc, raw_bits.view);
+  auto one_rand_list = intgen.make_permutation(bitgen_param.num_ones());
+
+  std::cout << "pdep by default     : " << (yaef::pdep_select_enabled() ? "on" : "off") << '\n';
+  for (bool use_pdep : {true, false}) {
+    if (yaef::force_pdep_select(use_pdep) != use_pdep) {
+      std::cout << "\npdep is not available\n";
+      continue;
+    }
+    std::cout << "\nbenchmark with pdep " << (use_pdep ? "on" : "off") << ": \n";
+    benchmark_select_in_word(words, ranks);
+    benchmark_select_in_bits(bits, one_rand_list);
+  }
+
+  return 0;
+}
@@ -1,6 +1,8 @@
 #include <chrono>
+#include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <random>
 
 #include "yaef/yaef.hpp"
 
@@ -8,13 +10,15 @@
 #include "common.hpp"
 
 using yaef::details::selectable_dense_bits;
+using yaef::details::interleaved_dense_bits;
 using yaef::details::aligned_allocator;
 using clock_type = std::chrono::steady_clock;
 using f64nanos = std::chrono::duration<double, std::nano>;
 using f64millis = std::chrono::duration<double, std::milli>;
 
-void benchmark_select_one(const selectable_dense_bits &bits, size_t num_ones, 
-                          const std::vector<size_t> &rand_indices) {
+template<typename BitsT>
+void benchmark_select_one(const BitsT &bits, const std::vector<size_t> &rand_indices) {
+  const size_t num_ones = rand_indices.size();
   auto bench_seq_start = clock_type::now();
   for (size_t i = 0; i < num_ones; ++i) {
     size_t index = bits.select_one(i);
@@ -44,9 +48,9 @@ void benchmark_select_one(const selectable_dense_bits &bits, size_t num_ones,
             << "randomly(ops)       : " << bench_rand_nanos.count() / num_ones << "ns/int\n";
 }
 
-void benchmark_select_zero(const selectable_dense_bits &bits, size_t num_zeros, 
-                          const std::vector<size_t> &rand_indices) {
-
+template<typename BitsT>
+void benchmark_select_zero(const BitsT &bits, const std::vector<size_t> &rand_indices) {
+  const size_t num_zeros = rand_indices.size();
   auto bench_seq_start = clock_type::now();
   for (size_t i = 0; i < num_zeros; ++i) {
     size_t index = bits.select_zero(i);
@@ -76,25 +80,89 @@ void benchmark_select_zero(const selectable_dense_bits &bits, size_t num_zeros,
             << "randomly(ops)       : " << bench_rand_nanos.count() / num_zeros << "ns/int\n";
 }
 
-int main() {
-  constexpr size_t NUM_BITS = 5000000;
-  constexpr double ONE_DENSITY = 0.5;
+template<typename BitsT>
+void benchmark_rank_one(const BitsT &bits, const std::vector<size_t> &rand_indices) {
+  const size_t num_bits = rand_indices.size();
+  auto bench_seq_start = clock_type::now();
+  for (size_t i = 0; i < num_bits; ++i) {
+    size_t rank = bits.rank_one(i);
+    dont_optimize(rank);
+  }
+  auto bench_seq_end = clock_type::now();
+  auto bench_seq_nanos = std::chrono::duration_cast<f64nanos>(bench_seq_end - bench_seq_start);
+  auto bench_seq_millis = std::chrono::duration_cast<f64millis>(bench_seq_end - bench_seq_start);
 
-  aligned_allocator<uint8_t, 64> alloc;
-  yaef::test_utils::bit_generator bitgen;
-  yaef::test_utils::uniform_int_generator<size_t> intgen;
+  auto bench_rand_start = clock_type::now();
+  for (size_t i = 0; i < num_bits; ++i) {
+    size_t rank = bits.rank_one(rand_indices[i]);
+    dont_optimize(rank);
+  }
+  auto bench_rand_end = clock_type::now();
+  auto bench_rand_nanos = std::chrono::duration_cast<f64nanos>(bench_rand_end - bench_rand_start);
+  auto bench_rand_millis = std::chrono::duration_cast<f64millis>(bench_rand_end - bench_rand_start);
 
-  auto bitgen_param = yaef::test_utils::bit_generator::param::by_one_density(NUM_BITS, ONE_DENSITY);
-  auto raw_bits = bitgen.make_bits(bitgen_param);
+  std::cout << std::fixed << std::setprecision(3)
+            << "benchmark for rank_one: \n"
+            << "sequentially(total) : " << bench_seq_millis.count() << "ms\n"
+            << "sequentially(ops)   : " << bench_seq_nanos.count() / num_bits << "ns/int\n"
+            << "randomly(total)     : " << bench_rand_millis.count() << "ms\n"
+            << "randomly(ops)       : " << bench_rand_nanos.count() / num_bits << "ns/int\n";
+}
+
+// random words, so that about half of the bits are 1s
+yaef::test_utils::bit_generator::result make_random_bits(size_t num_bits) {
+  auto result = yaef::test_utils::bit_generator{}.make_uninit_bits(num_bits);
+  std::mt19937_64 rng{114514};
+  uint64_t *blocks = result.view.blocks();
+  const size_t num_blocks = result.view.num_blocks();
+  for (size_t i = 0; i < num_blocks; ++i) {
+    blocks[i] = rng();
+  }
+  if (num_bits % 64 != 0) {
+    blocks[num_blocks - 1] &= yaef::details::bits64::make_mask_lsb1(num_bits % 64);
+  }
+  return result;
+}
+
+std::vector<size_t> make_queries(size_t num_candidates, size_t max_num_queries) {
+  if (num_candidates <= max_num_queries) {
+    return yaef::test_utils::uniform_int_generator<size_t>{}.make_permutation(num_candidates);
+  }
+  return yaef::test_utils::uniform_int_generator<size_t>{0, num_candidates - 1}.make_list(max_num_queries);
+}
+
+// usage: selectable_dense_bits_benchmark [num_bits] [max_num_queries]
+// the default size stays in the cache, pass a larger one, e.g. 2147483648, to measure off-cache 
+// queries. at most `max_num_queries` random queries are run for each operation.
+int main(int argc, char *argv[]) {
+  const size_t num_bits = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+  const size_t max_num_queries = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 5000000;
+
+  aligned_allocator<uint8_t, 64> alloc;
+  auto raw_bits = make_random_bits(num_bits);
+  interleaved_dense_bits interleaved_bits(alloc, raw_bits.view);
   selectable_dense_bits bits(alloc, raw_bits.view);
-  size_t num_ones = bitgen_param.num_ones();
-  size_t num_zeros = bitgen_param.num_zeros();
-  auto one_rand_list = intgen.make_permutation(num_ones);
-  auto zero_rand_list = intgen.make_permutation(num_zeros);
+  const auto stat_info = yaef::details::bits64::stats_bits(raw_bits.view);
+  auto one_rand_list = make_queries(stat_info.num_ones(), max_num_queries);
+  auto zero_rand_list = make_queries(stat_info.num_zeros(), max_num_queries);
+  auto bit_rand_list = make_queries(num_bits, max_num_queries);
 
-  benchmark_select_one(bits, num_ones, one_rand_list);
+  std::cout << "==== selectable_dense_bits (" << num_bits << " bits) ====\n";
+  benchmark_select_one(bits, one_rand_list);
   std::cout << '\n';
-  benchmark_select_zero(bits, num_zeros, zero_rand_list);
+  benchmark_select_zero(bits, zero_rand_list);
+  std::cout << '\n';
+  bits.build_rank_directory(alloc);
+  benchmark_rank_one(bits, bit_rand_list);
+  std::cout << "space with rank      : " << bits.space_usage_in_bytes() << "B\n";
 
+  std::cout << "\n==== interleaved_dense_bits ====\n";
+  benchmark_select_one(interleaved_bits, one_rand_list);
+  std::cout << '\n';
+  benchmark_select_zero(interleaved_bits, zero_rand_list);
+  std::cout << '\n';
+  benchmark_rank_one(interleaved_bits, bit_rand_list);
+
+  interleaved_bits.deallocate(alloc);
   return 0;
-}
\ No newline at end of file
+}
@@ -1,11 +1,14 @@
 #include <unordered_set>
 
+#include "catch2/generators/catch_generators.hpp"
 #include "catch2/catch_test_macros.hpp"
 
 #include "yaef/yaef.hpp"
 
 #include "utils/bit_generator.hpp"
 #include "utils/defer_guard.hpp"
+#include "utils/random.hpp"
+#include "utils/simd_tier.hpp"
 
 TEST_CASE("bit_view_test", "[private]") {
     using yaef::details::bits64::bit_view;
@@ -94,4 +97,199 @@ TEST_CASE("bit_view_test", "[private]") {
         const size_t num_residual_bits = NUM_BITS - (num_blocks - 1) * BITS_BLOCK_WIDTH;
         REQUIRE(blocks[num_blocks - 1] == yaef::details::bits64::make_mask_lsb1(num_residual_bits));
     }
-}
\ No newline at end of file
+
+    SECTION("boolean operations") {
+        namespace bits64 = yaef::details::bits64;
+
+        const size_t num_bits = GENERATE(1, 100, 640, 6000, 70001);
+        constexpr size_t NUM_SRCS = 5;
+        const yaef::bitwise_op ops[] = {yaef::bitwise_op::bit_and, yaef::bitwise_op::bit_or,
+                                        yaef::bitwise_op::bit_xor, yaef::bitwise_op::bit_and_not};
+
+        yaef::test_utils::uniform_int_generator<uint64_t> block_gen{0, UINT64_MAX, yaef::test_utils::make_random_seed()};
+        std::vector<yaef::test_utils::bit_generator::result> srcs;
+        for (size_t i = 0; i < NUM_SRCS; ++i) {
+            yaef::test_utils::bit_generator gen;
+            auto gen_result = gen.make_uninit_bits(num_bits);
+            const size_t num_blocks = gen_result.view.num_blocks();
+            // bias towards 1s so that the and-ed results are not all empty
+            const auto blocks0 = block_gen.make_list(num_blocks), blocks1 = block_gen.make_list(num_blocks);
+            for (size_t j = 0; j < num_blocks; ++j) {
+                gen_result.view.blocks()[j] = blocks0[j] | blocks1[j];
+            }
+            if (num_bits % 64 != 0) {
+                gen_result.view.blocks()[num_blocks - 1] &= bits64::make_mask_lsb1(num_bits % 64);
+            }
+            srcs.push_back(std::move(gen_result));
+        }
+
+        auto apply = [](yaef::bitwise_op op, uint64_t lhs, uint64_t rhs) -> uint64_t {
+            switch (op) {
+            case yaef::bitwise_op::bit_and : return lhs & rhs;
+            case yaef::bitwise_op::bit_or  : return lhs | rhs;
+            case yaef::bitwise_op::bit_xor : return lhs ^ rhs;
+            default                        : return lhs & ~rhs;
+            }
+        };
+
+        std::allocator<uint8_t> alloc;
+        auto dst = yaef::details::allocate_bits(alloc, num_bits);
+        YAEF_DEFER { yaef::details::deallocate_bits(alloc, dst); };
+        const size_t num_blocks = dst.num_blocks();
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (yaef::bitwise_op op : ops) {
+                std::vector<uint64_t> expected(num_blocks);
+                for (size_t j = 0; j < num_blocks; ++j) {
+                    expected[j] = apply(op, srcs[0].view.blocks()[j], srcs[1].view.blocks()[j]);
+                }
+                REQUIRE(dst.assign_combined(op, srcs[0].view, srcs[1].view) == 0);
+                REQUIRE(std::equal(expected.begin(), expected.end(), dst.blocks()));
+                const size_t expected_num_ones = bits64::popcount_range(expected.data(), num_blocks);
+                REQUIRE(dst.assign_combined(op, srcs[0].view, srcs[1].view, true) == expected_num_ones);
+
+                // in place, the padding bits of the last block stay cleared
+                dst.set_all_bits();
+                for (size_t j = 0; j < num_blocks; ++j) {
+                    expected[j] = apply(op, ~0ULL, srcs[2].view.blocks()[j]);
+                }
+                if (num_bits % 64 != 0) {
+                    expected.back() &= bits64::make_mask_lsb1(num_bits % 64);
+                }
+                const size_t num_ones = dst.combine_with(op, srcs[2].view, true);
+                REQUIRE(std::equal(expected.begin(), expected.end(), dst.blocks()));
+                REQUIRE(num_ones == bits64::popcount_range(expected.data(), num_blocks));
+
+                // multiple operands, folded from the left
+                const bit_view *src_views[NUM_SRCS];
+                for (size_t i = 0; i < NUM_SRCS; ++i) {
+                    src_views[i] = &srcs[i].view;
+                }
+                for (size_t num_srcs = 1; num_srcs <= NUM_SRCS; ++num_srcs) {
+                    for (size_t j = 0; j < num_blocks; ++j) {
+                        uint64_t block = srcs[0].view.blocks()[j];
+                        for (size_t i = 1; i < num_srcs; ++i) {
+                            block = apply(op, block, srcs[i].view.blocks()[j]);
+                        }
+                        expected[j] = block;
+                    }
+                    REQUIRE(dst.assign_combined(op, src_views, num_srcs, true) == 
+                            bits64::popcount_range(expected.data(), num_blocks));
+                    REQUIRE(std::equal(expected.begin(), expected.end(), dst.blocks()));
+                }
+            }
+        });
+
+        yaef::bit_buffer<> buf0(num_bits), buf1(num_bits), buf2(num_bits);
+        std::copy_n(srcs[0].view.blocks(), num_blocks, buf0.block_data());
+        std::copy_n(srcs[1].view.blocks(), num_blocks, buf1.block_data());
+        std::copy_n(srcs[2].view.blocks(), num_blocks, buf2.block_data());
+        yaef::bit_buffer<> expected_buf{buf0};
+        expected_buf.combine_with(yaef::bitwise_op::bit_and, buf1);
+        const size_t expected_num_ones = expected_buf.combine_with(yaef::bitwise_op::bit_and, buf2, true);
+
+        yaef::bit_buffer<> result;
+        REQUIRE(result.assign_combined(yaef::bitwise_op::bit_and, {&buf0, &buf1, &buf2}, true) == expected_num_ones);
+        REQUIRE(result.size() == num_bits);
+        REQUIRE(std::equal(result.block_data(), result.block_data() + num_blocks, expected_buf.block_data()));
+        REQUIRE(buf0.assign_combined(yaef::bitwise_op::bit_and, {&buf0, &buf1, &buf2}) == 0);
+        REQUIRE(std::equal(buf0.block_data(), buf0.block_data() + num_blocks, expected_buf.block_data()));
+    }
+
+    SECTION("find next and previous bits") {
+        using gen_param = yaef::test_utils::bit_generator::param;
+
+        const size_t num_bits = GENERATE(100, 1000, 70001);
+        const double one_density = GENERATE(0.001, 0.5, 0.999);
+        const size_t num_ones = std::max<size_t>(1, std::min<size_t>(num_bits - 1, num_bits * one_density));
+
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits(gen_param::by_size(num_bits - num_ones, num_ones));
+        const bit_view &bits = gen_result.view;
+
+        std::vector<size_t> next_one(num_bits + 1, num_bits), next_zero(num_bits + 1, num_bits),
+                            prev_one(num_bits, num_bits), prev_zero(num_bits, num_bits);
+        for (size_t i = num_bits; i > 0; --i) {
+            next_one[i - 1] = bits.get_bit(i - 1) ? i - 1 : next_one[i];
+            next_zero[i - 1] = !bits.get_bit(i - 1) ? i - 1 : next_zero[i];
+        }
+        for (size_t i = 0; i < num_bits; ++i) {
+            const size_t prev_one_before = i != 0 ? prev_one[i - 1] : num_bits, 
+                         prev_zero_before = i != 0 ? prev_zero[i - 1] : num_bits;
+            prev_one[i] = bits.get_bit(i) ? i : prev_one_before;
+            prev_zero[i] = !bits.get_bit(i) ? i : prev_zero_before;
+        }
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (size_t i = 0; i < num_bits; ++i) {
+                REQUIRE(bits.find_next_one(i) == next_one[i]);
+                REQUIRE(bits.find_next_zero(i) == next_zero[i]);
+                REQUIRE(bits.find_prev_one(i) == prev_one[i]);
+                REQUIRE(bits.find_prev_zero(i) == prev_zero[i]);
+            }
+            REQUIRE(bits.find_next_one(num_bits) == num_bits);
+            REQUIRE(bits.find_next_zero(num_bits) == num_bits);
+        });
+    }
+
+    SECTION("run statistics and run cursor") {
+        namespace bits64 = yaef::details::bits64;
+        using gen_param = yaef::test_utils::bit_generator::param;
+
+        const size_t num_bits = GENERATE(2, 64, 100, 1000, 70001);
+        const double one_density = GENERATE(0.001, 0.5, 0.999);
+        const size_t num_ones = std::max<size_t>(1, std::min<size_t>(num_bits - 1, num_bits * one_density));
+
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits(gen_param::by_size(num_bits - num_ones, num_ones));
+        const bit_view &bits = gen_result.view;
+
+        std::vector<std::pair<size_t, size_t>> expected_one_runs, expected_zero_runs;
+        for (size_t i = 0; i < num_bits; ) {
+            const bool bit = bits.get_bit(i);
+            size_t j = i;
+            while (j < num_bits && bits.get_bit(j) == bit) { ++j; }
+            (bit ? expected_one_runs : expected_zero_runs).emplace_back(i, j - i);
+            i = j;
+        }
+        bits64::bits_stat_info::run_histogram expected_histogram{};
+        size_t expected_longest_one_run = 0, expected_longest_zero_run = 0;
+        for (const auto &run : expected_one_runs) {
+            expected_longest_one_run = std::max(expected_longest_one_run, run.second);
+        }
+        for (const auto &run : expected_zero_runs) {
+            expected_longest_zero_run = std::max(expected_longest_zero_run, run.second);
+            ++expected_histogram[yaef::details::bits64::bit_width(run.second)];
+        }
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            const auto stats = bits64::stats_bits(bits, true);
+            REQUIRE(stats.has_run_stats());
+            REQUIRE(stats.num_ones() == num_ones);
+            REQUIRE(stats.num_one_runs() == expected_one_runs.size());
+            REQUIRE(stats.num_zero_runs() == expected_zero_runs.size());
+            REQUIRE(stats.longest_one_run() == expected_longest_one_run);
+            REQUIRE(stats.longest_zero_run() == expected_longest_zero_run);
+            REQUIRE(stats.gap_width_histogram() == expected_histogram);
+            REQUIRE_FALSE(bits64::stats_bits(bits).has_run_stats());
+
+            std::vector<std::pair<size_t, size_t>> one_runs;
+            for (bits64::bitmap_run_cursor cursor{bits}; cursor.is_valid(); cursor.next()) {
+                one_runs.push_back(cursor.current());
+            }
+            REQUIRE(one_runs == expected_one_runs);
+
+            const size_t pos = num_bits / 2;
+            bits64::bitmap_run_cursor cursor{bits, pos};
+            auto iter = std::find_if(expected_one_runs.begin(), expected_one_runs.end(), 
+                                     [pos](const std::pair<size_t, size_t> &run) { return run.first + run.second > pos; });
+            if (iter == expected_one_runs.end()) {
+                REQUIRE_FALSE(cursor.is_valid());
+            } else {
+                const size_t start = std::max(pos, iter->first);
+                REQUIRE(cursor.start() == start);
+                REQUIRE(cursor.length() == iter->first + iter->second - start);
+            }
+        });
+    }
+}
@@ -1,8 +1,38 @@
+#include "catch2/generators/catch_generators.hpp"
 #include "catch2/catch_test_macros.hpp"
 
+#include <stdexcept>
+
 #include "yaef/yaef.hpp"
 
 #include "utils/bit_generator.hpp"
+#include "utils/simd_tier.hpp"
+
+template<typename CursorT>
+static void test_advance_and_skip(const yaef::details::bits64::bit_view &bits, const std::vector<size_t> &expected) {
+    const size_t end_pos = bits.num_blocks() * 64;
+    for (size_t step : {1, 2, 7, 64, 1000}) {
+        CursorT cursor{bits};
+        size_t i = 0;
+        for (; i + step < expected.size(); i += step) {
+            REQUIRE(cursor.current() == expected[i]);
+            cursor.advance_by(step);
+        }
+        REQUIRE(cursor.current() == expected[i]);
+        cursor.advance_by(expected.size() - i);
+        REQUIRE(!cursor.is_valid());
+    }
+
+    yaef::test_utils::uniform_int_generator<size_t> pos_gen{0, bits.size() - 1, yaef::test_utils::make_random_seed()};
+    CursorT cursor{bits};
+    for (size_t pos : pos_gen.make_sorted_list(100)) {
+        cursor.skip_to(pos);
+        auto iter = std::lower_bound(expected.begin(), expected.end(), pos);
+        REQUIRE(cursor.current() == (iter != expected.end() ? *iter : end_pos));
+    }
+    cursor.skip_to(end_pos);
+    REQUIRE(!cursor.is_valid());
+}
 
 TEST_CASE("bitset_foreach_test", "[private]") {
     using yaef::details::bits64::bitmap_foreach_onebit_cursor;
@@ -112,4 +142,80 @@ TEST_CASE("bitset_foreach_test", "[private]") {
         REQUIRE(bits == bits_ref);
         REQUIRE(popcnt == NUM_ZEROS - skipped_popcnt);
     }
+    SECTION("foreach over long gaps") {
+        constexpr size_t NUM_SPARSE_BITS = 100000;
+        const size_t num_sparse_ones = GENERATE(1, 10, 100, 1000);
+
+        auto sparse_res = gen.make_bits_with_both_indices(bit_gen_param::by_size(NUM_SPARSE_BITS - num_sparse_ones, num_sparse_ones));
+        const auto &sparse_bits = sparse_res.view;
+        // flip the bits so that the zeros are sparse as well
+        auto flipped_res = gen.make_uninit_bits(NUM_SPARSE_BITS);
+        for (size_t i = 0; i < sparse_bits.num_blocks(); ++i) {
+            flipped_res.view.blocks()[i] = ~sparse_bits.blocks()[i];
+        }
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            std::vector<size_t> indices;
+            for (bitmap_foreach_onebit_cursor cursor{sparse_bits}; cursor.is_valid(); cursor.next()) {
+                indices.push_back(cursor.current());
+            }
+            REQUIRE(indices == sparse_res.one_indices);
+
+            indices.clear();
+            for (bitmap_foreach_zerobit_cursor cursor{flipped_res.view}; cursor.is_valid(); cursor.next()) {
+                indices.push_back(cursor.current());
+            }
+            REQUIRE(indices == sparse_res.one_indices);
+
+            const size_t num_skipped = sparse_res.one_indices.back();
+            bitmap_foreach_onebit_cursor cursor{sparse_bits, num_skipped};
+            REQUIRE(cursor.current() == num_skipped);
+            cursor.next();
+            REQUIRE(!cursor.is_valid());
+        });
+    }
+    SECTION("advance by and skip to") {
+        constexpr size_t NUM_SKIP_BITS = 100000;
+        const size_t num_skip_ones = GENERATE(10, 1000, 50000, 99000);
+
+        auto skip_res = gen.make_bits_with_both_indices(bit_gen_param::by_size(NUM_SKIP_BITS - num_skip_ones, num_skip_ones));
+        test_advance_and_skip<bitmap_foreach_onebit_cursor>(skip_res.view, skip_res.one_indices);
+        // the padding bits of the last block are 0s as well
+        std::vector<size_t> zero_indices{skip_res.zero_indices};
+        for (size_t i = NUM_SKIP_BITS; i < skip_res.view.num_blocks() * 64; ++i) {
+            zero_indices.push_back(i);
+        }
+        test_advance_and_skip<bitmap_foreach_zerobit_cursor>(skip_res.view, zero_indices);
+    }
+    SECTION("parallel foreach and decode") {
+        const size_t chunk_num_blocks = GENERATE(1, 7, 1000, 1 << 14);
+        const size_t num_blocks = bits.num_blocks();
+
+        std::vector<size_t> expected;
+        yaef::details::bits64::bitmap_foreach_onebit(bits.blocks(), num_blocks, [&](size_t pos) { expected.push_back(pos); });
+
+        yaef::thread_executor exec{4};
+        std::vector<uint64_t> decoded(NUM_ONES + 1, 0);
+        REQUIRE(yaef::details::bits64::parallel_decode_onebits(bits.blocks(), num_blocks, decoded.data(), 
+                                                               exec, chunk_num_blocks) == NUM_ONES);
+        REQUIRE(decoded.back() == 0);
+        REQUIRE(std::equal(expected.begin(), expected.end(), decoded.begin()));
+
+        std::vector<size_t> visited(NUM_ONES, 0);
+        REQUIRE(yaef::details::bits64::parallel_bitmap_foreach_onebit(bits.blocks(), num_blocks, [&](size_t pos, size_t rank) {
+            visited[rank] = pos;
+        }, yaef::sequential_executor{}, chunk_num_blocks) == NUM_ONES);
+        REQUIRE(visited == expected);
+
+        std::fill(visited.begin(), visited.end(), 0);
+        REQUIRE(yaef::details::bits64::parallel_bitmap_foreach_onebit(bits.blocks(), num_blocks, [&](size_t pos, size_t rank) {
+            visited[rank] = pos;
+        }, exec, chunk_num_blocks) == NUM_ONES);
+        REQUIRE(visited == expected);
+
+        // the first exception of a task is rethrown after the threads are joined
+        REQUIRE_THROWS_AS(exec(1000, [](size_t i) {
+            if (i % 100 == 7) { throw std::runtime_error{"task failed"}; }
+        }), std::runtime_error);
+    }
 }
\ No newline at end of file
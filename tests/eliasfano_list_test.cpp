@@ -1,6 +1,10 @@
 #include "catch2/generators/catch_generators.hpp"
 #include "catch2/catch_test_macros.hpp"
 
+#include <atomic>
+#include <sstream>
+#include <thread>
+
 #include "yaef/yaef.hpp"
 
 #include "utils/int_generator.hpp"
@@ -40,6 +44,19 @@ TEST_CASE("eliasfano_list_test", "[public]") {
         }
     }
 
+    SECTION("random access with assumed low width") {
+        using int_type = uint32_t;
+        yaef::test_utils::uniform_int_generator<int_type> gen{
+            0, 1 << 20, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(4096);
+
+        yaef::eliasfano_list<int_type> list(yaef::from_sorted, ints.begin(), ints.end());
+        REQUIRE(list.low_width() == 8);
+        for (size_t i = 0; i < ints.size(); ++i) {
+            REQUIRE(list.at(i, yaef::assumed_width_t<8>{}) == ints[i]);
+        }
+    }
+
     SECTION("construct from sorted signed integer list and random access") {
         using int_type = int32_t;
         yaef::test_utils::uniform_int_generator<int_type> gen{
@@ -137,6 +154,26 @@ TEST_CASE("eliasfano_list_test", "[public]") {
         }
     }
 
+    SECTION("lower_bound and upper_bound within long buckets") {
+        // most of the values are clustered in a narrow range, so they share a few high parts
+        yaef::test_utils::uniform_int_generator<uint32_t> gen{0, 1 << 20, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_list(10000);
+        for (size_t i = 0; i < 40000; ++i) {
+            ints.push_back(500000 + yaef::test_utils::random<uint32_t>(0, 4096));
+        }
+        std::sort(ints.begin(), ints.end());
+
+        yaef::eliasfano_list<uint32_t> list{yaef::from_sorted, ints.begin(), ints.end()};
+        for (size_t i = 0; i < 2000; ++i) {
+            const uint32_t target = i % 2 == 0 ? ints[yaef::test_utils::random<size_t>(0, ints.size() - 1)] :
+                                                 yaef::test_utils::random<uint32_t>(0, 1 << 20);
+            const size_t expected_lower = std::lower_bound(ints.begin(), ints.end(), target) - ints.begin();
+            const size_t expected_upper = std::upper_bound(ints.begin(), ints.end(), target) - ints.begin();
+            REQUIRE(list.index_of_lower_bound(target) == expected_lower);
+            REQUIRE(list.index_of_upper_bound(target) == expected_upper);
+        }
+    }
+
     SECTION("iterate forward") {
         using int_type = uint32_t;
         yaef::test_utils::uniform_int_generator<uint32_t> gen{
@@ -157,6 +194,26 @@ TEST_CASE("eliasfano_list_test", "[public]") {
         }
     }
 
+    SECTION("advance iterators") {
+        using int_type = uint32_t;
+        yaef::test_utils::uniform_int_generator<uint32_t> gen{
+            0, 1 << 24, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(100000);
+        yaef::eliasfano_list<int_type> list{yaef::from_sorted, ints.begin(), ints.end()};
+
+        for (size_t step : {1, 3, 100, 5000}) {
+            auto iter = list.begin();
+            size_t i = 0;
+            for (; i + step < ints.size(); i += step) {
+                REQUIRE(*iter == ints[i]);
+                REQUIRE(iter.to_index() == i);
+                iter.advance_by(step);
+            }
+            REQUIRE(*iter == ints[i]);
+            REQUIRE(iter.advance_by(ints.size() - i) == list.end());
+        }
+    }
+
     SECTION("iterate backward") {
         using int_type = uint32_t;
         yaef::test_utils::uniform_int_generator<uint32_t> gen{
@@ -240,4 +297,162 @@ TEST_CASE("eliasfano_list_test", "[public]") {
         yaef::eliasfano_list<uint32_t> dup_list{1, 2, 2, 3, 3, 5};
         REQUIRE(dup_list.has_duplicates());
     }
-}
\ No newline at end of file
+
+    SECTION("sampling policies") {
+        using int_type = uint32_t;
+        using policy_list_type = yaef::eliasfano_list<int_type, 
+            yaef::details::aligned_allocator<uint8_t, 32>, yaef::low_latency_sampling_policy>;
+        yaef::test_utils::uniform_int_generator<int_type> gen{
+            0, 1u << 20, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(80000);
+
+        policy_list_type list(yaef::from_sorted, ints.begin(), ints.end());
+        yaef::eliasfano_list<int_type> default_list(yaef::from_sorted, ints.begin(), ints.end());
+        REQUIRE(list.size() == ints.size());
+        for (size_t i = 0; i < ints.size(); ++i) {
+            REQUIRE(list.at(i) == ints[i]);
+        }
+        REQUIRE(list.space_usage_in_bytes() > default_list.space_usage_in_bytes());
+
+        const size_t bytes_mem_size = 2 * 1024 * 1024;
+        std::unique_ptr<uint8_t []> bytes_mem(new uint8_t[bytes_mem_size]);
+        REQUIRE(yaef::serialize_to_buf(list, bytes_mem.get(), bytes_mem_size) == yaef::error_code::success);
+        {
+            policy_list_type deserialized_list;
+            REQUIRE(yaef::deserialize_from_buf(deserialized_list, bytes_mem.get(), bytes_mem_size) == yaef::error_code::success);
+            REQUIRE(deserialized_list == list);
+        }
+        {
+            // the samples of another policy must not be read back
+            yaef::eliasfano_list<int_type> deserialized_list;
+            REQUIRE(yaef::deserialize_from_buf(deserialized_list, bytes_mem.get(), bytes_mem_size) == 
+                    yaef::error_code::deserialize_mismatched_policy);
+        }
+    }
+
+    SECTION("access-only lists") {
+        using int_type = uint32_t;
+        using access_only_list_type = yaef::eliasfano_list<int_type, 
+            yaef::details::aligned_allocator<uint8_t, 32>, yaef::access_only_sampling_policy>;
+        yaef::test_utils::uniform_int_generator<int_type> gen{
+            0, 1u << 20, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(80000);
+
+        access_only_list_type list(yaef::from_sorted, ints.begin(), ints.end());
+        yaef::eliasfano_list<int_type> default_list(yaef::from_sorted, ints.begin(), ints.end());
+        REQUIRE(list.space_usage_in_bytes() < default_list.space_usage_in_bytes());
+        size_t i = 0;
+        for (auto iter = list.begin(); iter != list.end(); ++iter, ++i) {
+            REQUIRE(*iter == ints[i]);
+            REQUIRE(list.at(i) == ints[i]);
+        }
+
+        // a searchable list builds the samples of the 0s when it is loaded
+        const size_t bytes_mem_size = 2 * 1024 * 1024;
+        std::unique_ptr<uint8_t []> bytes_mem(new uint8_t[bytes_mem_size]);
+        REQUIRE(yaef::serialize_to_buf(list, bytes_mem.get(), bytes_mem_size) == yaef::error_code::success);
+        yaef::eliasfano_list<int_type> deserialized_list;
+        REQUIRE(yaef::deserialize_from_buf(deserialized_list, bytes_mem.get(), bytes_mem_size) == yaef::error_code::success);
+        REQUIRE(deserialized_list == default_list);
+        for (size_t j = 0; j < ints.size(); j += 97) {
+            REQUIRE(*deserialized_list.lower_bound(ints[j]) == ints[j]);
+        }
+    }
+
+    SECTION("lists serialized before 0.2.0") {
+        using int_type = uint32_t;
+        yaef::test_utils::uniform_int_generator<int_type> gen{
+            0, 1u << 24, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(100000);
+        yaef::eliasfano_list<int_type> list(yaef::from_sorted, ints.begin(), ints.end());
+
+        // the older layout is the current one without the header words of the high bits
+        const size_t num_header_bytes = 5 * sizeof(uint64_t);
+        std::ostringstream stream;
+        REQUIRE(yaef::serialize_to_stream(list, stream) == yaef::error_code::success);
+        std::istringstream old_stream{stream.str().substr(num_header_bytes)};
+        yaef::eliasfano_list<int_type> deserialized_list;
+        REQUIRE(yaef::deserialize_from_stream(deserialized_list, old_stream) == yaef::error_code::success);
+        REQUIRE(deserialized_list == list);
+        for (size_t i = 0; i < ints.size(); i += 13) {
+            REQUIRE(deserialized_list.at(i) == ints[i]);
+            REQUIRE(*deserialized_list.lower_bound(ints[i]) == ints[i]);
+        }
+    }
+
+    SECTION("lists serialized without select samples") {
+        using int_type = uint32_t;
+        yaef::test_utils::uniform_int_generator<int_type> gen{
+            0, 1u << 24, yaef::test_utils::make_random_seed()};
+        auto ints = gen.make_sorted_list(200000);
+        yaef::eliasfano_list<int_type> list(yaef::from_sorted, ints.begin(), ints.end());
+
+        std::ostringstream full_stream, compact_stream;
+        REQUIRE(yaef::serialize_to_stream(list, full_stream) == yaef::error_code::success);
+        REQUIRE(yaef::serialize_to_stream(list, compact_stream, yaef::serialize_flags::omit_select_samples) == 
+                yaef::error_code::success);
+        const std::string compact_bytes = compact_stream.str();
+        REQUIRE(compact_bytes.size() < full_stream.str().size());
+
+        auto load = [&compact_bytes](yaef::eliasfano_list<int_type> &out) {
+            std::istringstream stream{compact_bytes};
+            REQUIRE(yaef::deserialize_from_stream(out, stream, yaef::deserialize_flags::lazy_select_samples) == 
+                    yaef::error_code::success);
+        };
+        {
+            // the samples are rebuilt on load unless asked to wait for the first select
+            yaef::eliasfano_list<int_type> deserialized_list;
+            std::istringstream stream{compact_bytes};
+            REQUIRE(yaef::deserialize_from_stream(deserialized_list, stream) == yaef::error_code::success);
+            REQUIRE(deserialized_list.space_usage_in_bytes() == list.space_usage_in_bytes());
+            REQUIRE(deserialized_list == list);
+        }
+        {
+            // the samples are rebuilt by the first select
+            yaef::eliasfano_list<int_type> deserialized_list;
+            load(deserialized_list);
+            REQUIRE(deserialized_list.space_usage_in_bytes() < list.space_usage_in_bytes());
+            REQUIRE(deserialized_list == list);
+            for (size_t i = 0; i < ints.size(); i += 13) {
+                REQUIRE(deserialized_list.at(i) == ints[i]);
+            }
+            REQUIRE(deserialized_list.space_usage_in_bytes() == list.space_usage_in_bytes());
+            for (size_t i = 0; i < ints.size(); i += 97) {
+                REQUIRE(*deserialized_list.lower_bound(ints[i]) == ints[i]);
+            }
+        }
+        {
+            yaef::eliasfano_list<int_type> deserialized_list;
+            load(deserialized_list);
+            // copies made before the first select build their own samples
+            yaef::eliasfano_list<int_type> copied_list = deserialized_list;
+            REQUIRE(*copied_list.lower_bound(ints[ints.size() / 2]) == ints[ints.size() / 2]);
+            // a list that has not built its samples yet is written without them
+            std::ostringstream stream;
+            REQUIRE(yaef::serialize_to_stream(deserialized_list, stream) == yaef::error_code::success);
+            REQUIRE(stream.str() == compact_bytes);
+        }
+        {
+            // concurrent first selects build the samples once
+            yaef::eliasfano_list<int_type> deserialized_list;
+            load(deserialized_list);
+            const size_t num_threads = 8;
+            std::vector<std::thread> threads;
+            std::atomic<size_t> num_mismatches{0};
+            for (size_t t = 0; t < num_threads; ++t) {
+                threads.emplace_back([&, t]() {
+                    for (size_t i = t; i < ints.size(); i += num_threads * 7) {
+                        if (deserialized_list.at(i) != ints[i]) {
+                            num_mismatches.fetch_add(1, std::memory_order_relaxed);
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            REQUIRE(num_mismatches.load() == 0);
+            REQUIRE(deserialized_list.space_usage_in_bytes() == list.space_usage_in_bytes());
+        }
+    }
+}
@@ -65,6 +65,18 @@ TEST_CASE("eliasfano_sparse_bitmap", "[public]") {
         REQUIRE(bitmap.find_last() == 70);
     }
 
+    SECTION("construct with the number of indexed bits") {
+        uint64_t blocks[] = {0xAA, 0x55, 0xF0F0};
+        yaef::eliasfano_sparse_bitmap<true> one_bitmap(blocks, 144, 16);
+        REQUIRE(one_bitmap.count_one() == 16);
+        REQUIRE(one_bitmap.select(8) == 128 + 4);
+        yaef::eliasfano_sparse_bitmap<false> zero_bitmap(blocks, 144, 128);
+        REQUIRE(zero_bitmap.count_zero() == 128);
+
+        REQUIRE_THROWS_AS((yaef::eliasfano_sparse_bitmap<true>(blocks, 144, 15)), std::out_of_range);
+        REQUIRE_THROWS_AS((yaef::eliasfano_sparse_bitmap<true>(blocks, 144, 17)), std::invalid_argument);
+    }
+
     SECTION("swap") {
         yaef::eliasfano_sparse_bitmap<true> bitmap1;
 
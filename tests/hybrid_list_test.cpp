@@ -12,6 +12,10 @@ using hyb_list = yaef::hybrid_list<uint32_t, yaef::details::aligned_allocator<ui
     yaef::hybrid_methods::eliasgamma_unique_gap
 >;
 
+using gap_list = yaef::hybrid_list<uint32_t, yaef::details::aligned_allocator<uint8_t, 32>,
+    yaef::hybrid_methods::fixed_gap
+>;
+
 TEST_CASE("hybrid_list_test", "[public]") {
     yaef::test_utils::uniform_int_generator<uint32_t> int_gen(0, 25000 * 80, 114514);
     auto data = int_gen.make_sorted_set(25000 * 20);
@@ -50,4 +54,17 @@ TEST_CASE("hybrid_list_test", "[public]") {
             REQUIRE(expected == actual);
         }
     }
-}
\ No newline at end of file
+
+    SECTION("fixed gap partitions") {
+        auto list = gap_list(yaef::from_sorted, data.begin(), data.end());
+
+        for (size_t i = 0; i < data.size(); ++i) {
+            REQUIRE(list[i] == data[i]);
+        }
+        for (size_t i = 0; i < data.size(); ++i) {
+            uint32_t target = yaef::test_utils::random(data.front(), data.back());
+            size_t expected = std::lower_bound(data.begin(), data.end(), target) - data.begin();
+            REQUIRE(list.index_of_lower_bound(target) == expected);
+        }
+    }
+}
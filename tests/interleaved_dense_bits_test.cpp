@@ -0,0 +1,103 @@
+#include "catch2/generators/catch_generators.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include <sstream>
+
+#include "yaef/yaef.hpp"
+
+#include "utils/bit_generator.hpp"
+#include "utils/defer_guard.hpp"
+#include "utils/random.hpp"
+
+template<typename AllocT>
+static void test_interleaved_bits(AllocT &alloc, 
+                                  const yaef::test_utils::bit_generator::result_with_both_indices &gen_result) {
+    auto bits = gen_result.view;
+    const size_t num_bits = bits.size();
+    const auto &one_indices = gen_result.one_indices;
+    const auto &zero_indices = gen_result.zero_indices;
+
+    yaef::details::interleaved_dense_bits interleaved_bits{alloc, bits};
+    YAEF_DEFER {
+        interleaved_bits.deallocate(alloc);
+    };
+    REQUIRE(interleaved_bits.size() == num_bits);
+    REQUIRE(interleaved_bits.num_ones() == one_indices.size());
+    // each line must be in one cache line, whatever the alignment of the allocator
+    REQUIRE(reinterpret_cast<uintptr_t>(interleaved_bits.lines_data()) % 64 == 0);
+
+    SECTION("get bits") {
+        for (size_t i = 0; i < num_bits; ++i) {
+            REQUIRE(interleaved_bits.get_bit(i) == bits.get_bit(i));
+        }
+    }
+
+    SECTION("rank bit-one and bit-zero") {
+        size_t expected = 0;
+        for (size_t i = 0; i <= num_bits; ++i) {
+            REQUIRE(interleaved_bits.rank_one(i) == expected);
+            REQUIRE(interleaved_bits.rank_zero(i) == i - expected);
+            if (expected < one_indices.size() && one_indices[expected] == i) {
+                ++expected;
+            }
+        }
+    }
+
+    SECTION("select bit-one and bit-zero positions") {
+        for (size_t i = 0; i < one_indices.size(); ++i) {
+            REQUIRE(interleaved_bits.select_one(i) == one_indices[i]);
+        }
+        for (size_t i = 0; i < zero_indices.size(); ++i) {
+            REQUIRE(interleaved_bits.select_zero(i) == zero_indices[i]);
+        }
+    }
+
+    SECTION("duplicate") {
+        auto dup = interleaved_bits.duplicate(alloc);
+        YAEF_DEFER {
+            dup.deallocate(alloc);
+        };
+        REQUIRE(reinterpret_cast<uintptr_t>(dup.lines_data()) % 64 == 0);
+        REQUIRE(dup == interleaved_bits);
+        for (size_t i = 0; i < one_indices.size(); ++i) {
+            REQUIRE(dup.select_one(i) == one_indices[i]);
+        }
+    }
+
+    SECTION("serialize and deserialize") {
+        std::stringstream stream;
+        yaef::details::serializer ser{yaef::details::make_unique_obj<yaef::details::ostream_writer_context>(stream)};
+        REQUIRE(interleaved_bits.serialize(ser) == yaef::error_code::success);
+
+        yaef::details::interleaved_dense_bits loaded;
+        yaef::details::deserializer deser{yaef::details::make_unique_obj<yaef::details::istream_reader_context>(stream)};
+        REQUIRE(loaded.deserialize(alloc, deser) == yaef::error_code::success);
+        YAEF_DEFER {
+            loaded.deallocate(alloc);
+        };
+        REQUIRE(reinterpret_cast<uintptr_t>(loaded.lines_data()) % 64 == 0);
+        REQUIRE(loaded == interleaved_bits);
+        for (size_t i = 0; i <= num_bits; ++i) {
+            REQUIRE(loaded.rank_one(i) == interleaved_bits.rank_one(i));
+        }
+    }
+}
+
+TEST_CASE("interleaved_dense_bits_test", "[private]") {
+    const size_t num_bits = GENERATE(128, 383, 384, 385, 1024, 9876, 60000);
+    const double one_density = GENERATE(0.01, 0.1, 0.5, 0.9, 0.99);
+
+    using gen_param = yaef::test_utils::bit_generator::param;
+    yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+    auto gen_result = gen.make_bits_with_both_indices(gen_param::by_one_density(num_bits, one_density));
+
+    SECTION("64-byte aligned allocator") {
+        yaef::details::aligned_allocator<uint8_t, 64> alloc;
+        test_interleaved_bits(alloc, gen_result);
+    }
+
+    SECTION("32-byte aligned allocator") {
+        yaef::details::aligned_allocator<uint8_t, 32> alloc;
+        test_interleaved_bits(alloc, gen_result);
+    }
+}
@@ -4,6 +4,27 @@
 
 #include "utils/int_generator.hpp"
 #include "utils/defer_guard.hpp"
+#include "utils/simd_tier.hpp"
+
+// reads and rewrites every value with the width known at compile time
+struct assumed_width_roundtrip {
+    yaef::details::bits64::packed_int_view &ints;
+    const std::vector<uint64_t> &values;
+
+    template<uint32_t W>
+    bool operator()(yaef::assumed_width_t<W> w) const {
+        for (size_t i = 0; i < ints.size(); ++i) {
+            if (ints.get_value(i, w) != values[i]) { return false; }
+        }
+        for (size_t i = 0; i < ints.size(); ++i) {
+            ints.set_value(i, values[ints.size() - i - 1], w);
+        }
+        for (size_t i = 0; i < ints.size(); ++i) {
+            if (ints.get_value(i) != values[ints.size() - i - 1]) { return false; }
+        }
+        return true;
+    }
+};
 
 TEST_CASE("packed_int_view_test", "[private]") {
     using yaef::details::bits64::packed_int_view;
@@ -113,4 +134,281 @@ TEST_CASE("packed_int_view_test", "[private]") {
         const size_t num_residual_bits = NUM_INTS * VAL_WIDTH - (num_blocks - 1) * BLOCK_WIDTH;
         REQUIRE(blocks[num_blocks - 1] == yaef::details::bits64::make_mask_lsb1(num_residual_bits));
     }
+
+    SECTION("bulk unpack (get_values)") {
+        constexpr size_t NUM_INTS = 1000;
+        std::vector<uint64_t> out(NUM_INTS);
+        for (uint32_t width = 1; width <= 64; ++width) {
+            const uint64_t max_int = yaef::details::bits64::make_mask_lsb1(width);
+            yaef::test_utils::uniform_int_generator<uint64_t> gen{0, max_int};
+            auto gen_result = gen.make_list(NUM_INTS);
+
+            auto ints = yaef::details::allocate_uninit_packed_ints(alloc, width, NUM_INTS);
+            YAEF_DEFER { yaef::details::deallocate_packed_ints(alloc, ints); };
+            for (size_t i = 0; i < ints.size(); ++i) {
+                ints.set_value(i, gen_result[i]);
+            }
+
+            yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+                for (size_t first : {0, 1, 7, 8, 13, 500}) {
+                    for (size_t last : {first, first + 1, first + 8, first + 37, NUM_INTS - 9, NUM_INTS}) {
+                        if (last < first || last > NUM_INTS) {
+                            continue;
+                        }
+                        ints.get_values(first, last, out.data());
+                        for (size_t i = first; i < last; ++i) {
+                            REQUIRE(out[i - first] == gen_result[i]);
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    SECTION("bulk pack (set_values)") {
+        constexpr size_t NUM_INTS = 1000;
+        for (uint32_t width = 1; width <= 64; ++width) {
+            yaef::test_utils::uniform_int_generator<uint64_t> gen;
+            auto old_values = gen.make_list(NUM_INTS);
+            auto new_values = gen.make_list(NUM_INTS);
+            const uint64_t mask = yaef::details::bits64::make_mask_lsb1(width);
+
+            auto ints = yaef::details::allocate_uninit_packed_ints(alloc, width, NUM_INTS);
+            YAEF_DEFER { yaef::details::deallocate_packed_ints(alloc, ints); };
+
+            yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+                for (size_t first : {0, 1, 7, 8, 13, 500}) {
+                    for (size_t last : {first, first + 1, first + 8, first + 37, NUM_INTS - 9, NUM_INTS}) {
+                        if (last < first || last > NUM_INTS) {
+                            continue;
+                        }
+                        for (size_t i = 0; i < NUM_INTS; ++i) {
+                            ints.set_value(i, old_values[i]);
+                        }
+                        ints.set_values(first, last, new_values.data() + first);
+                        for (size_t i = 0; i < NUM_INTS; ++i) {
+                            const uint64_t expected = (first <= i && i < last) ? new_values[i] : old_values[i];
+                            REQUIRE(ints.get_value(i) == (expected & mask));
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    SECTION("random access with assumed width") {
+        constexpr size_t NUM_INTS = 1000;
+        for (uint32_t width = 1; width <= 64; ++width) {
+            yaef::test_utils::uniform_int_generator<uint64_t> gen{0, yaef::details::bits64::make_mask_lsb1(width)};
+            auto gen_result = gen.make_list(NUM_INTS);
+
+            auto ints = yaef::details::allocate_uninit_packed_ints(alloc, width, NUM_INTS);
+            YAEF_DEFER { yaef::details::deallocate_packed_ints(alloc, ints); };
+            for (size_t i = 0; i < ints.size(); ++i) {
+                ints.set_value(i, gen_result[i]);
+            }
+            REQUIRE(yaef::visit_assumed_width(width, assumed_width_roundtrip{ints, gen_result}));
+        }
+    }
+
+    SECTION("find first not less") {
+        constexpr size_t NUM_INTS = 1000;
+        for (uint32_t width : {1, 3, 8, 13, 31, 32, 56, 57, 64}) {
+            const uint64_t max_int = yaef::details::bits64::make_mask_lsb1(width);
+            yaef::test_utils::uniform_int_generator<uint64_t> gen{0, max_int};
+            auto gen_result = gen.make_list(NUM_INTS);
+            yaef::packed_int_buffer<> ints(gen_result.begin(), gen_result.end(), width);
+
+            const uint64_t targets[] = {0, 1, max_int / 2, max_int - max_int / 64, max_int};
+            yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+                for (uint64_t target : targets) {
+                    for (size_t first : {0, 1, 8, 13, 500}) {
+                        for (size_t last : {first, first + 7, first + 64, NUM_INTS - 3, NUM_INTS}) {
+                            if (last < first || last > NUM_INTS) {
+                                continue;
+                            }
+                            auto iter = std::find_if(gen_result.begin() + first, gen_result.begin() + last, 
+                                                     [&](uint64_t val) { return val >= target; });
+                            const size_t expected = std::distance(gen_result.begin(), iter);
+                            REQUIRE(ints.find_not_less(first, last, target) == expected);
+                        }
+                    }
+                }
+            });
+        }
+    }
+
+    SECTION("prefix sums and delta transforms") {
+        constexpr size_t NUM_INTS = 1000;
+        for (uint32_t width : {1, 3, 8, 13, 31, 32, 56, 57, 64}) {
+            const uint64_t max_int = yaef::details::bits64::make_mask_lsb1(width);
+            yaef::test_utils::uniform_int_generator<uint64_t> gen{0, max_int};
+            auto gen_result = gen.make_list(NUM_INTS);
+            yaef::packed_int_buffer<> ints(gen_result.begin(), gen_result.end(), width);
+
+            yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+                for (size_t first : {0, 1, 8, 13, 500}) {
+                    for (size_t last : {first, first + 7, first + 64, NUM_INTS - 3, NUM_INTS}) {
+                        if (last < first || last > NUM_INTS) {
+                            continue;
+                        }
+                        std::vector<uint64_t> expected(last - first);
+                        std::partial_sum(gen_result.begin() + first, gen_result.begin() + last, expected.begin());
+                        for (auto &sum : expected) {
+                            sum += 42;
+                        }
+                        std::vector<uint64_t> sums(last - first);
+                        const uint64_t last_sum = ints.get_prefix_sums(first, last, sums.data(), 42);
+                        REQUIRE(sums == expected);
+                        REQUIRE(last_sum == (expected.empty() ? 42 : expected.back()));
+                    }
+                }
+
+                yaef::packed_int_buffer<> deltas = ints;
+                deltas.delta_encode(13, NUM_INTS);
+                REQUIRE(deltas.get_value(12) == gen_result[12]);
+                REQUIRE(deltas.get_value(13) == gen_result[13]);
+                for (size_t i = 14; i < NUM_INTS; ++i) {
+                    REQUIRE(deltas.get_value(i) == ((gen_result[i] - gen_result[i - 1]) & max_int));
+                }
+                deltas.delta_decode(13, NUM_INTS);
+                REQUIRE(deltas == ints);
+            });
+        }
+    }
+
+    SECTION("shrink to fit width") {
+        constexpr size_t NUM_INTS = 1000;
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (uint32_t width : {1, 3, 8, 13, 31, 56, 57, 64}) {
+                const uint64_t max_int = yaef::details::bits64::make_mask_lsb1(width);
+                yaef::test_utils::uniform_int_generator<uint64_t> gen{0, max_int};
+                auto gen_result = gen.make_list(NUM_INTS);
+                gen_result[yaef::test_utils::random<size_t>(0, NUM_INTS - 1)] = max_int;
+
+                // the widths up to PACKED_GROUP_MAX_WIDTH are searched by the max kernels
+                const uint32_t init_width = width <= 56 ? std::min<uint32_t>(width + 8, 56) : 64;
+                yaef::packed_int_buffer<> ints(gen_result.begin(), gen_result.end(), init_width);
+                auto check_max_values = [&]() {
+                    REQUIRE(ints.find_max_value() == max_int);
+                    REQUIRE(ints.find_max_value(1, 1) == 0);
+                    const std::pair<size_t, size_t> ranges[] = {{1, NUM_INTS}, {3, NUM_INTS - 5}, {7, 7 + 33}, {31, 521}};
+                    for (const auto &range : ranges) {
+                        const uint64_t expected = *std::max_element(gen_result.begin() + range.first, 
+                                                                    gen_result.begin() + range.second);
+                        REQUIRE(ints.find_max_value(range.first, range.second) == expected);
+                    }
+                };
+                check_max_values();
+
+                const size_t old_bytes = ints.num_blocks() * sizeof(uint64_t);
+                const size_t old_space = ints.space_usage_in_bytes();
+                const size_t saved = ints.shrink_to_fit_width();
+                REQUIRE(ints.width() == width);
+                REQUIRE(saved == old_bytes - ints.num_blocks() * sizeof(uint64_t));
+                REQUIRE(ints.space_usage_in_bytes() == old_space);
+                for (size_t i = 0; i < NUM_INTS; ++i) {
+                    REQUIRE(ints.get_value(i) == gen_result[i]);
+                }
+                check_max_values();
+                REQUIRE(ints.shrink_to_fit_width() == 0);
+
+                // the bits beyond the size are cleared by the repacking
+                ints.resize(NUM_INTS + 100);
+                for (size_t i = NUM_INTS; i < NUM_INTS + 100; ++i) {
+                    REQUIRE(ints.get_value(i) == 0);
+                }
+                ints.resize(NUM_INTS);
+                ints.shrink_to_fit();
+                REQUIRE(ints.space_usage_in_bytes() == old_space - saved);
+            }
+        });
+    }
+
+    SECTION("push_back and append") {
+        constexpr size_t NUM_INTS = 5000;
+        yaef::test_utils::uniform_int_generator<uint64_t> gen{0, (1 << 12) - 1};
+        auto gen_result = gen.make_list(NUM_INTS);
+
+        yaef::packed_int_buffer<> ints(12, 0);
+        ints.reserve(100);
+        REQUIRE(ints.capacity() >= 100);
+        REQUIRE(ints.space_usage_in_bytes() >= sizeof(ints) + 100 * 12 / 8);
+        for (size_t i = 0; i < NUM_INTS / 2; ++i) {
+            ints.push_back(gen_result[i]);
+        }
+        ints.append(gen_result.begin() + NUM_INTS / 2, gen_result.end());
+        REQUIRE(ints.size() == NUM_INTS);
+        REQUIRE(ints.capacity() >= NUM_INTS);
+        REQUIRE(ints == yaef::packed_int_buffer<>(gen_result.begin(), gen_result.end(), 12));
+
+        ints.resize(NUM_INTS / 3);
+        ints.resize(NUM_INTS);
+        for (size_t i = 0; i < NUM_INTS; ++i) {
+            REQUIRE(ints[i] == (i < NUM_INTS / 3 ? gen_result[i] : 0));
+        }
+        ints.shrink_to_fit();
+        REQUIRE(ints.capacity() * ints.width() < NUM_INTS * ints.width() + 64);
+        REQUIRE(ints.space_usage_in_bytes() == sizeof(ints) + yaef::details::bits64::idiv_ceil(NUM_INTS * 12, 64) * 8);
+    }
+
+    SECTION("push_back and append with auto widen") {
+        constexpr size_t NUM_INTS = 5000;
+        yaef::test_utils::uniform_int_generator<uint64_t> gen;
+        auto gen_result = gen.make_list(NUM_INTS);
+        for (size_t i = 0; i < NUM_INTS; ++i) {
+            // the values grow slowly, so the elements are widened many times
+            gen_result[i] >>= 63 - i * 63 / NUM_INTS;
+        }
+
+        yaef::packed_int_buffer<> ints;
+        for (size_t i = 0; i < NUM_INTS / 2; ++i) {
+            ints.push_back(yaef::auto_widen, gen_result[i]);
+        }
+        ints.append(yaef::auto_widen, gen_result.begin() + NUM_INTS / 2, gen_result.end());
+        REQUIRE(ints.size() == NUM_INTS);
+        REQUIRE(ints.width() == yaef::details::bits64::bit_width(*std::max_element(gen_result.begin(), gen_result.end())));
+        for (size_t i = 0; i < NUM_INTS; ++i) {
+            REQUIRE(ints[i] == gen_result[i]);
+        }
+    }
+
+    SECTION("predicate scan") {
+        constexpr size_t NUM_INTS = 1000;
+        for (uint32_t width : {1, 3, 8, 13, 31, 32, 56, 57, 64}) {
+            const uint64_t max_int = yaef::details::bits64::make_mask_lsb1(width);
+            yaef::test_utils::uniform_int_generator<uint64_t> gen{0, max_int};
+            auto gen_result = gen.make_list(NUM_INTS);
+            yaef::packed_int_buffer<> ints(gen_result.begin(), gen_result.end(), width);
+
+            const uint64_t pivot = gen_result[NUM_INTS / 2];
+            const yaef::int_predicate preds[] = {
+                yaef::int_predicate::less(pivot),
+                yaef::int_predicate::equal(pivot),
+                yaef::int_predicate::greater_equal(pivot),
+                yaef::int_predicate::between(max_int / 4, max_int / 2),
+                yaef::int_predicate::less(0),
+                yaef::int_predicate::greater(max_int)
+            };
+            yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+                for (const auto &pred : preds) {
+                    auto bits = ints.scan(pred);
+                    REQUIRE(bits.size() == NUM_INTS);
+                    for (size_t i = 0; i < NUM_INTS; ++i) {
+                        REQUIRE(bits[i] == pred(gen_result[i]));
+                    }
+
+                    yaef::bit_buffer<> sub_bits;
+                    for (size_t first : {1, 8, 13}) {
+                        const size_t last = NUM_INTS - first;
+                        ints.scan(first, last, pred, sub_bits);
+                        REQUIRE(sub_bits.size() == last - first);
+                        for (size_t i = first; i < last; ++i) {
+                            REQUIRE(sub_bits[i - first] == pred(gen_result[i]));
+                        }
+                    }
+                }
+            });
+        }
+    }
 }
\ No newline at end of file
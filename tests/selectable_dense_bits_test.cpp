@@ -1,12 +1,66 @@
 #include "catch2/generators/catch_generators.hpp"
 #include "catch2/catch_test_macros.hpp"
 
+#include <sstream>
+
 #include "yaef/yaef.hpp"
 
 #include "utils/bit_generator.hpp"
 #include "utils/defer_guard.hpp"
+#include "utils/int_generator.hpp"
 #include "utils/random.hpp"
 
+template<typename PolicyT>
+static std::string serialize_bits(const yaef::details::basic_selectable_dense_bits<PolicyT> &bits,
+                                  yaef::serialize_flags flags = yaef::serialize_flags::none) {
+    std::ostringstream stream;
+    yaef::details::serializer ser{yaef::details::make_unique_obj<yaef::details::ostream_writer_context>(stream), flags};
+    REQUIRE(bits.serialize(ser) == yaef::error_code::success);
+    return stream.str();
+}
+
+template<typename PolicyT, typename AllocT>
+static yaef::error_code deserialize_bits(AllocT &alloc, yaef::details::basic_selectable_dense_bits<PolicyT> &bits, 
+                                         const std::string &bytes, 
+                                         yaef::deserialize_flags flags = yaef::deserialize_flags::none) {
+    std::istringstream stream{bytes};
+    yaef::details::deserializer deser{yaef::details::make_unique_obj<yaef::details::istream_reader_context>(stream), flags};
+    return bits.deserialize(alloc, deser);
+}
+
+template<typename PolicyT>
+static void test_select_with_policy(size_t num_bits, double one_density) {
+    using gen_param = yaef::test_utils::bit_generator::param;
+    yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+    auto gen_result = gen.make_bits_with_one_indices(
+        gen_param::by_one_density(num_bits, one_density));
+    auto bits = gen_result.view;
+    const auto &one_indices = gen_result.one_indices;
+
+    std::vector<size_t> zero_indices;
+    for (size_t i = 0, j = 0; i < num_bits; ++i) {
+        if (j < one_indices.size() && one_indices[j] == i) {
+            ++j;
+        } else {
+            zero_indices.push_back(i);
+        }
+    }
+
+    std::allocator<uint8_t> alloc;
+    yaef::details::basic_selectable_dense_bits<PolicyT> selectable_bits{alloc, bits};
+    gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+    YAEF_DEFER {
+        selectable_bits.deallocate(alloc);
+    };
+
+    for (size_t i = 0; i < one_indices.size(); ++i) {
+        REQUIRE(selectable_bits.select_one(i) == one_indices[i]);
+    }
+    for (size_t i = 0; i < zero_indices.size(); ++i) {
+        REQUIRE(selectable_bits.select_zero(i) == zero_indices[i]);
+    }
+}
+
 TEST_CASE("selectable_dense_bits_test", "[private]") {
     SECTION("select bit-one positions") {
         const size_t num_bits = GENERATE(1024, 8192, 9876, 10000, 60000);
@@ -90,4 +144,252 @@ TEST_CASE("selectable_dense_bits_test", "[private]") {
             REQUIRE(actual == expected);
         }
     }
+
+    SECTION("rank bit-one and bit-zero") {
+        const size_t num_bits = GENERATE(64, 100, 511, 512, 513, 9876, 60000);
+        const double one_density = GENERATE(0.1, 0.5, 0.9);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_one_indices(
+            gen_param::by_one_density(num_bits, one_density));
+        auto bits = gen_result.view;
+        const auto &one_indices = gen_result.one_indices;
+
+        std::allocator<uint8_t> alloc;
+        yaef::details::selectable_dense_bits selectable_bits{alloc, bits};
+        gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+        YAEF_DEFER {
+            selectable_bits.deallocate(alloc);
+        };
+
+        REQUIRE_FALSE(selectable_bits.has_rank_directory());
+        const size_t old_space = selectable_bits.space_usage_in_bytes();
+        const std::string bytes_without_rank = serialize_bits(selectable_bits);
+        selectable_bits.build_rank_directory(alloc);
+        REQUIRE(selectable_bits.has_rank_directory());
+        REQUIRE(selectable_bits.space_usage_in_bytes() > old_space);
+
+        // the rank directory is written only if it is built
+        const std::string bytes_with_rank = serialize_bits(selectable_bits);
+        REQUIRE(bytes_with_rank.size() > bytes_without_rank.size());
+        {
+            yaef::details::selectable_dense_bits deserialized_bits;
+            REQUIRE(deserialize_bits(alloc, deserialized_bits, bytes_without_rank) == yaef::error_code::success);
+            REQUIRE_FALSE(deserialized_bits.has_rank_directory());
+            deserialized_bits.deallocate(alloc);
+            REQUIRE(deserialize_bits(alloc, deserialized_bits, bytes_with_rank) == yaef::error_code::success);
+            REQUIRE(deserialized_bits.has_rank_directory());
+            REQUIRE(deserialized_bits.rank_one(num_bits) == one_indices.size());
+            deserialized_bits.deallocate(alloc);
+        }
+
+        size_t expected = 0;
+        for (size_t i = 0; i <= num_bits; ++i) {
+            REQUIRE(selectable_bits.rank_one(i) == expected);
+            REQUIRE(selectable_bits.rank_zero(i) == i - expected);
+            if (expected < one_indices.size() && one_indices[expected] == i) {
+                ++expected;
+            }
+        }
+    }
+
+    SECTION("select with other sampling policies") {
+        const size_t num_bits = GENERATE(1024, 9876, 60000, 300000);
+        const double one_density = GENERATE(0.01, 0.5, 0.99);
+
+        test_select_with_policy<yaef::okanohara_sadakane_sampling_policy>(num_bits, one_density);
+        test_select_with_policy<yaef::low_latency_sampling_policy>(num_bits, one_density);
+        test_select_with_policy<yaef::compact_sampling_policy>(num_bits, one_density);
+        test_select_with_policy<yaef::darray_sampling_policy<256, 8, 1024>>(num_bits, one_density);
+    }
+
+    SECTION("scan statistics count the cache lines") {
+        const size_t num_bits = 60000;
+        const double one_density = GENERATE(0.1, 0.5);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_one_indices(
+            gen_param::by_one_density(num_bits, one_density));
+        auto bits = gen_result.view;
+        const auto &one_indices = gen_result.one_indices;
+
+        std::allocator<uint8_t> alloc;
+        yaef::details::basic_selectable_dense_bits<yaef::compact_sampling_policy> selectable_bits{alloc, bits};
+        gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+        YAEF_DEFER {
+            selectable_bits.deallocate(alloc);
+        };
+
+        // the scan checks the sampled block and 2 more blocks inline, then the kernel reads 8 
+        // blocks per step, the whole group of the target included
+        constexpr size_t NUM_INLINE_BLOCKS = 3, KERNEL_STEP_NUM_BLOCKS = 8;
+        const size_t num_blocks = bits.num_blocks();
+        auto line_of = [&bits](size_t block_index) { 
+            return reinterpret_cast<uintptr_t>(bits.blocks() + block_index) / 64; 
+        };
+        size_t num_kernel_scans = 0;
+        for (size_t i = 0; i < one_indices.size(); ++i) {
+            auto stats = selectable_bits.select_one_scan_stats(i);
+            if (stats.num_select == 0) {
+                REQUIRE(stats.num_cache_lines == 0);
+                continue;
+            }
+            REQUIRE(stats.num_select == 1);
+            const size_t first = stats.first_block_index, target = one_indices[i] / 64;
+            REQUIRE(first <= target);
+
+            size_t last_read = target;
+            if (target - first < NUM_INLINE_BLOCKS) {
+                REQUIRE(stats.num_popcount == target - first + 1);
+                REQUIRE(stats.num_kernel_steps == 0);
+            } else {
+                const size_t kernel_first = first + NUM_INLINE_BLOCKS;
+                const size_t num_steps = (target - kernel_first) / KERNEL_STEP_NUM_BLOCKS + 1;
+                REQUIRE(stats.num_popcount == NUM_INLINE_BLOCKS);
+                REQUIRE(stats.num_kernel_steps == num_steps);
+                last_read = std::min(kernel_first + num_steps * KERNEL_STEP_NUM_BLOCKS, num_blocks) - 1;
+                ++num_kernel_scans;
+            }
+            REQUIRE(stats.num_cache_lines == line_of(last_read) - line_of(first) + 1);
+        }
+        // the sparse samples of the compact policy leave long scans at these densities
+        REQUIRE(num_kernel_scans != 0);
+    }
+
+    SECTION("select in batches") {
+        const size_t num_bits = GENERATE(1024, 9876, 300000);
+        const double one_density = GENERATE(0.01, 0.5, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_one_indices(
+            gen_param::by_one_density(num_bits, one_density));
+        auto bits = gen_result.view;
+        const auto &one_indices = gen_result.one_indices;
+        const size_t num_ones = one_indices.size(), num_zeros = num_bits - num_ones;
+
+        std::allocator<uint8_t> alloc;
+        yaef::details::selectable_dense_bits selectable_bits{alloc, bits};
+        gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+        YAEF_DEFER {
+            selectable_bits.deallocate(alloc);
+        };
+
+        // random ranks, in a count that leaves a partial group
+        yaef::test_utils::uniform_int_generator<size_t> rank_gen{0, num_bits, yaef::test_utils::make_random_seed()};
+        const size_t num_ranks = 1000 + 7;
+        std::vector<size_t> one_ranks = rank_gen.make_list(num_ranks), 
+                            zero_ranks = rank_gen.make_list(num_ranks);
+        for (size_t i = 0; i < num_ranks; ++i) {
+            one_ranks[i] %= num_ones;
+            zero_ranks[i] %= num_zeros;
+        }
+
+        std::vector<size_t> out(num_ranks);
+        selectable_bits.select_one_batch(one_ranks.data(), num_ranks, out.data());
+        for (size_t i = 0; i < num_ranks; ++i) {
+            REQUIRE(out[i] == one_indices[one_ranks[i]]);
+        }
+        selectable_bits.select_zero_batch(zero_ranks.data(), num_ranks, out.data());
+        for (size_t i = 0; i < num_ranks; ++i) {
+            REQUIRE(out[i] == selectable_bits.select_zero(zero_ranks[i]));
+        }
+        selectable_bits.select_one_batch(one_ranks.data(), 0, out.data());
+    }
+
+    SECTION("one-sided select samples") {
+        const size_t num_bits = GENERATE(1024, 9876, 300000);
+        const double one_density = GENERATE(0.01, 0.5, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_one_indices(
+            gen_param::by_one_density(num_bits, one_density));
+        auto bits = gen_result.view;
+        const auto &one_indices = gen_result.one_indices;
+
+        std::allocator<uint8_t> alloc;
+        yaef::details::selectable_dense_bits both_bits{alloc, yaef::details::duplicate_bits(alloc, bits)};
+        yaef::details::selectable_dense_bits one_bits{alloc, bits, yaef::select_sides::ones};
+        gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+        YAEF_DEFER {
+            both_bits.deallocate(alloc);
+            one_bits.deallocate(alloc);
+        };
+
+        REQUIRE(one_bits.has_select_samples(yaef::select_sides::ones));
+        REQUIRE_FALSE(one_bits.has_select_samples(yaef::select_sides::zeros));
+        REQUIRE(one_bits.space_usage_in_bytes() < both_bits.space_usage_in_bytes());
+        for (size_t i = 0; i < one_indices.size(); ++i) {
+            REQUIRE(one_bits.select_one(i) == one_indices[i]);
+        }
+
+        one_bits.build_select_samples(alloc, yaef::select_sides::zeros);
+        REQUIRE(one_bits.has_select_samples(yaef::select_sides::both));
+        REQUIRE(one_bits.space_usage_in_bytes() == both_bits.space_usage_in_bytes());
+        for (size_t i = 0; i < num_bits - one_indices.size(); ++i) {
+            REQUIRE(one_bits.select_zero(i) == both_bits.select_zero(i));
+        }
+    }
+
+    SECTION("select samples left out on serialization") {
+        const size_t num_bits = GENERATE(1024, 9876, 300000);
+        const double one_density = GENERATE(0.01, 0.5, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_one_indices(
+            gen_param::by_one_density(num_bits, one_density));
+        auto bits = gen_result.view;
+        const auto &one_indices = gen_result.one_indices;
+
+        std::allocator<uint8_t> alloc;
+        yaef::details::selectable_dense_bits selectable_bits{alloc, bits};
+        gen_result.mem.release(); // Ownership is transferred to selectable_dense_bits.
+        YAEF_DEFER {
+            selectable_bits.deallocate(alloc);
+        };
+        const std::string bytes = serialize_bits(selectable_bits, yaef::serialize_flags::omit_select_samples);
+        REQUIRE(bytes.size() < serialize_bits(selectable_bits).size());
+
+        auto require_same_selects = [&](const yaef::details::selectable_dense_bits &other) {
+            for (size_t i = 0; i < one_indices.size(); ++i) {
+                REQUIRE(other.select_one(i) == one_indices[i]);
+            }
+            for (size_t i = 0; i < num_bits - one_indices.size(); ++i) {
+                REQUIRE(other.select_zero(i) == selectable_bits.select_zero(i));
+            }
+        };
+        {
+            // the samples are built on load by default
+            yaef::details::selectable_dense_bits deserialized_bits;
+            REQUIRE(deserialize_bits(alloc, deserialized_bits, bytes) == yaef::error_code::success);
+            REQUIRE_FALSE(deserialized_bits.needs_select_samples());
+            REQUIRE(deserialized_bits.space_usage_in_bytes() == selectable_bits.space_usage_in_bytes());
+            require_same_selects(deserialized_bits);
+            deserialized_bits.deallocate(alloc);
+        }
+        {
+            // the shallow copies share the samples built through any of them
+            yaef::details::selectable_dense_bits deserialized_bits;
+            REQUIRE(deserialize_bits(alloc, deserialized_bits, bytes, yaef::deserialize_flags::lazy_select_samples) == 
+                    yaef::error_code::success);
+            yaef::details::selectable_dense_bits copied_bits = deserialized_bits;
+            REQUIRE(deserialized_bits.needs_select_samples());
+            REQUIRE(copied_bits.needs_select_samples());
+
+            copied_bits.ensure_select_samples(alloc);
+            REQUIRE_FALSE(deserialized_bits.needs_select_samples());
+            REQUIRE(deserialized_bits.space_usage_in_bytes() == selectable_bits.space_usage_in_bytes());
+            require_same_selects(copied_bits);
+            require_same_selects(deserialized_bits);
+
+            deserialized_bits.ensure_select_samples(alloc);
+            yaef::details::selectable_dense_bits late_copied_bits = deserialized_bits;
+            require_same_selects(late_copied_bits);
+            deserialized_bits.deallocate(alloc);
+        }
+    }
 }
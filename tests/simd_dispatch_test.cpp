@@ -0,0 +1,168 @@
+#include "catch2/generators/catch_generators.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+#include "yaef/yaef.hpp"
+
+#include "utils/bit_generator.hpp"
+#include "utils/defer_guard.hpp"
+#include "utils/random.hpp"
+#include "utils/simd_tier.hpp"
+
+TEST_CASE("simd_dispatch_test", "[private]") {
+    namespace bits64 = yaef::details::bits64;
+    YAEF_DEFER { 
+        yaef::reset_simd_tier(); 
+        yaef::force_pdep_select(yaef::details::get_cpu_features().fast_pdep);
+    };
+
+    SECTION("force tier") {
+        const auto detected = yaef::detected_simd_tier();
+        REQUIRE(yaef::force_simd_tier(yaef::simd_tier::scalar) == yaef::simd_tier::scalar);
+        REQUIRE(yaef::active_simd_tier() == yaef::simd_tier::scalar);
+        REQUIRE(yaef::force_simd_tier(yaef::simd_tier::avx512) == detected);
+        REQUIRE(yaef::active_simd_tier() == detected);
+    }
+
+    SECTION("select in word with and without pdep") {
+        yaef::test_utils::uniform_int_generator<uint64_t> gen{1, UINT64_MAX, yaef::test_utils::make_random_seed()};
+        const auto words = gen.make_list(1000);
+        for (bool use_pdep : {false, true}) {
+            yaef::force_pdep_select(use_pdep);
+            for (uint64_t word : words) {
+                const uint32_t num_ones = bits64::popcount(word);
+                for (uint32_t k = 0; k < num_ones; ++k) {
+                    REQUIRE(bits64::select_one(word, k) == bits64::select_one_fallback(word, k));
+                }
+            }
+        }
+    }
+
+    SECTION("popcount a range of blocks") {
+        constexpr size_t NUM_BITS = 64 * 1000;
+        const double one_density = GENERATE(0.01, 0.5, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits(gen_param::by_one_density(NUM_BITS, one_density));
+        const uint64_t *blocks = gen_result.view.blocks();
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (size_t n : {0, 1, 3, 4, 7, 8, 31, 32, 63, 64, 65, 100, 999, 1000}) {
+                size_t expected = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    expected += bits64::popcount(blocks[i]);
+                }
+                REQUIRE(bits64::popcount_range(blocks, n) == expected);
+                REQUIRE(bits64::popcount_range(blocks + 1, n - (n != 0)) == 
+                        expected - (n != 0 ? bits64::popcount(blocks[0]) : 0));
+            }
+        });
+    }
+
+    SECTION("variable-length block kernels handle partial vectors") {
+        constexpr size_t NUM_BITS = 1024;
+        const double one_density = GENERATE(0.1, 0.5, 0.9);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits(gen_param::by_one_density(NUM_BITS, one_density));
+        const uint64_t *blocks = gen_result.view.blocks();
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (size_t num_blocks : {1, 3, 4, 5, 8, 9, 13, 16}) {
+                const size_t num_bits = num_blocks * 64;
+                for (size_t k = 0; k <= num_bits + 1; ++k) {
+                    REQUIRE(bits64::popcount_blocks(blocks, num_blocks, k) == 
+                            bits64::popcount_blocks_scalar(blocks, num_blocks, k));
+                    REQUIRE(bits64::select_one_blocks(blocks, num_blocks, k) == 
+                            bits64::select_one_blocks_scalar(blocks, num_blocks, k));
+                    REQUIRE(bits64::select_zero_blocks(blocks, num_blocks, k) == 
+                            bits64::select_zero_blocks_scalar(blocks, num_blocks, k));
+                }
+            }
+        });
+    }
+
+    SECTION("block kernels agree with the scalar ones on every supported tier") {
+        constexpr size_t NUM_BITS = 1024;
+        const double one_density = GENERATE(0.01, 0.1, 0.5, 0.9, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits(gen_param::by_one_density(NUM_BITS, one_density));
+        const uint64_t *blocks = gen_result.view.blocks();
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier tier) {
+            REQUIRE(yaef::active_simd_tier() == tier);
+
+            for (size_t num_blocks : {8, 16}) {
+                const size_t num_bits = num_blocks * 64;
+                for (size_t k = 0; k <= num_bits; ++k) {
+                    const size_t expected = bits64::popcount_blocks_scalar(blocks, num_blocks, k);
+                    REQUIRE(bits64::popcount_blocks(blocks, num_blocks, k) == expected);
+                    if (num_blocks == 8) {
+                        REQUIRE(bits64::popcount_blocks_512(blocks, num_blocks, k) == expected);
+                    } else {
+                        REQUIRE(bits64::popcount_blocks_1024(blocks, num_blocks, k) == expected);
+                    }
+                }
+
+                const size_t num_ones = bits64::popcount_blocks_scalar(blocks, num_blocks, num_bits);
+                for (size_t k = 0; k < num_ones; ++k) {
+                    const size_t expected = bits64::select_one_blocks_scalar(blocks, num_blocks, k);
+                    REQUIRE(bits64::select_one_blocks(blocks, num_blocks, k) == expected);
+                    if (num_blocks == 8) {
+                        REQUIRE(bits64::select_one_blocks_512(blocks, num_blocks, k) == expected);
+                    } else {
+                        REQUIRE(bits64::select_one_blocks_1024(blocks, num_blocks, k) == expected);
+                    }
+                }
+
+                const size_t num_zeros = num_bits - num_ones;
+                for (size_t k = 0; k < num_zeros; ++k) {
+                    const size_t expected = bits64::select_zero_blocks_scalar(blocks, num_blocks, k);
+                    REQUIRE(bits64::select_zero_blocks(blocks, num_blocks, k) == expected);
+                    if (num_blocks == 8) {
+                        REQUIRE(bits64::select_zero_blocks_512(blocks, num_blocks, k) == expected);
+                    } else {
+                        REQUIRE(bits64::select_zero_blocks_1024(blocks, num_blocks, k) == expected);
+                    }
+                }
+            }
+        });
+    }
+    SECTION("decode the indices of bits") {
+        const size_t num_bits = GENERATE(640, 6400, 64000);
+        const double one_density = GENERATE(0.01, 0.1, 0.5, 0.9, 0.99);
+
+        using gen_param = yaef::test_utils::bit_generator::param;
+        yaef::test_utils::bit_generator gen{yaef::test_utils::make_random_seed()};
+        auto gen_result = gen.make_bits_with_both_indices(gen_param::by_one_density(num_bits, one_density));
+        const uint64_t *blocks = gen_result.view.blocks();
+        const size_t num_blocks = gen_result.view.num_blocks();
+        const uint32_t index_offset = 1000;
+
+        yaef::test_utils::for_each_supported_tier([&](yaef::simd_tier) {
+            for (bool bit : {true, false}) {
+                const auto &expected = bit ? gen_result.one_indices : gen_result.zero_indices;
+                // one more slot than needed, which must stay untouched
+                const uint64_t GUARD = 0xDEADBEEF;
+                std::vector<uint32_t> out32(expected.size() + 1, GUARD);
+                std::vector<uint64_t> out64(expected.size() + 1, GUARD);
+                const size_t capacity = expected.size();
+                const size_t num32 = bit ? bits64::decode_onebits(blocks, num_blocks, out32.data(), capacity, index_offset) :
+                                           bits64::decode_zerobits(blocks, num_blocks, out32.data(), capacity, index_offset);
+                const size_t num64 = bit ? bits64::decode_onebits(blocks, num_blocks, out64.data(), capacity) :
+                                           bits64::decode_zerobits(blocks, num_blocks, out64.data(), capacity);
+                REQUIRE(num32 == expected.size());
+                REQUIRE(num64 == expected.size());
+                REQUIRE(out32.back() == GUARD);
+                REQUIRE(out64.back() == GUARD);
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    REQUIRE(out32[i] == expected[i] + index_offset);
+                    REQUIRE(out64[i] == expected[i]);
+                }
+            }
+        });
+    }
+}
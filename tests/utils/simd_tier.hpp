@@ -0,0 +1,37 @@
+#ifndef __YAEF_UTILS_SIMD_TIER_HPP__
+#define __YAEF_UTILS_SIMD_TIER_HPP__
+#pragma once
+
+#include <cstdint>
+
+#include "yaef/yaef.hpp"
+
+namespace yaef {
+namespace test_utils {
+
+// restores the initial simd tier on scope exit, also when a failed REQUIRE throws
+class simd_tier_guard final {
+public:
+    simd_tier_guard() = default;
+    simd_tier_guard(const simd_tier_guard &) = delete;
+    simd_tier_guard &operator=(const simd_tier_guard &) = delete;
+
+    ~simd_tier_guard() { yaef::reset_simd_tier(); }
+};
+
+// call `f(tier)` with each tier supported by the cpu forced, from scalar up
+template<typename F>
+inline void for_each_supported_tier(F &&f) {
+    simd_tier_guard guard;
+    const auto max_tier = static_cast<uint32_t>(yaef::detected_simd_tier());
+    for (uint32_t tier = 0; tier <= max_tier; ++tier) {
+        const auto forced_tier = static_cast<yaef::simd_tier>(tier);
+        yaef::force_simd_tier(forced_tier);
+        f(forced_tier);
+    }
+}
+
+} // namespace test_utils
+} // namespace yaef
+
+#endif
\ No newline at end of file